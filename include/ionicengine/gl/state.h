@@ -0,0 +1,109 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_STATE_H
+#define IONICENGINE_STATE_H
+
+#include "../includes.h"
+
+namespace ionicengine
+{
+	/*!
+	 * Counts the state changes requested through the state cache.
+	 */
+	struct GLStateCounters
+	{
+		/*! The number of calls which reached the driver. */
+		uint64_t issued = 0;
+		/*! The number of calls elided because the state was already set. */
+		uint64_t skipped = 0;
+		/*! The number of program changes which reached the driver, included in issued. */
+		uint64_t program_switches = 0;
+		/*! The number of texture binds which reached the driver, included in issued. */
+		uint64_t texture_binds = 0;
+	};
+
+	/*!
+	 * Shadow copy of the OpenGL state of the current context.
+	 * Identical consecutive state changes never reach the driver.
+	 * Code issuing raw OpenGL state calls must call {@code glstate::invalidate} afterwards, the ScreenManager does it
+	 * after drawing each screen.
+	 */
+	namespace glstate
+	{
+		/*!
+		 * Forgets the cached state, the next state change of every kind reaches the driver.
+		 * Must be called when another context becomes current.
+		 */
+		extern void IONICENGINE_API invalidate();
+
+		/*!
+		 * Enables or disables an OpenGL capability.
+		 * @param capability The capability, e.g. GL_BLEND.
+		 * @param enabled True to enable the capability, else false.
+		 */
+		extern void IONICENGINE_API set_enabled(GLenum capability, bool enabled);
+
+		extern void IONICENGINE_API enable(GLenum capability);
+
+		extern void IONICENGINE_API disable(GLenum capability);
+
+		extern void IONICENGINE_API blend_func(GLenum source_factor, GLenum destination_factor);
+
+		/*!
+		 * Sets the blend factors of the color and alpha channels separately.
+		 */
+		extern void IONICENGINE_API blend_func_separate(GLenum source_color, GLenum destination_color,
+														GLenum source_alpha, GLenum destination_alpha);
+
+		extern void IONICENGINE_API use_program(uint32_t program);
+
+		extern void IONICENGINE_API bind_vertex_array(uint32_t vao);
+
+		extern void IONICENGINE_API bind_array_buffer(uint32_t vbo);
+
+		extern void IONICENGINE_API bind_framebuffer(uint32_t fbo);
+
+		/*!
+		 * Selects the active texture unit.
+		 * @param texture_unit The texture unit, e.g. GL_TEXTURE0.
+		 */
+		extern void IONICENGINE_API active_texture(GLenum texture_unit);
+
+		/*!
+		 * Binds a 2D texture to the active texture unit.
+		 * @param texture The OpenGL texture ID.
+		 */
+		extern void IONICENGINE_API bind_texture(uint32_t texture);
+
+		extern void IONICENGINE_API bind_texture(GLenum texture_unit, uint32_t texture);
+
+		/*!
+		 * Notifies the cache that a texture was deleted, OpenGL reverts its bindings to 0 and the ID may be reused.
+		 * @param texture The deleted OpenGL texture ID.
+		 */
+		extern void IONICENGINE_API forget_texture(uint32_t texture);
+
+		extern void IONICENGINE_API forget_vertex_array(uint32_t vao);
+
+		extern void IONICENGINE_API forget_buffer(uint32_t buffer);
+
+		extern void IONICENGINE_API forget_framebuffer(uint32_t fbo);
+
+		/*!
+		 * Gets the counters of issued and skipped state changes.
+		 * @return The counters.
+		 */
+		extern const GLStateCounters &IONICENGINE_API get_counters();
+
+		extern void IONICENGINE_API reset_counters();
+	}
+}
+
+#endif //IONICENGINE_STATE_H
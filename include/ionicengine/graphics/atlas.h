@@ -0,0 +1,164 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_ATLAS_H
+#define IONICENGINE_ATLAS_H
+
+#include "textures.h"
+#include <vector>
+
+#define IONIC_ATLAS_PAGE_SIZE 2048
+
+namespace ionicengine
+{
+	/*!
+	 * Rectangle bin packer using the skyline bottom-left heuristic.
+	 * The skyline stores the top edge of the packed rectangles, a rectangle is placed where its top ends the lowest.
+	 */
+	class IONICENGINE_API SkylinePacker
+	{
+	private:
+		struct Node
+		{
+			uint32_t x, y, width;
+		};
+
+		uint32_t _width, _height;
+		uint64_t _used_area = 0;
+		std::vector<Node> _skyline;
+
+		/*!
+		 * Checks whether a rectangle fits with its left edge at the specified skyline node.
+		 * @return The Y coordinate of the rectangle if it fits.
+		 */
+		std::optional<uint32_t> fit(size_t index, uint32_t width, uint32_t height) const;
+
+	public:
+		SkylinePacker(uint32_t width, uint32_t height);
+
+		uint32_t get_width() const;
+
+		uint32_t get_height() const;
+
+		/*!
+		 * Gets the ratio of the packed area over the whole area.
+		 * @return The occupancy between 0.0 and 1.0.
+		 */
+		float get_occupancy() const;
+
+		/*!
+		 * Finds a place for a rectangle of the specified size and reserves it.
+		 * @param width The width of the rectangle.
+		 * @param height The height of the rectangle.
+		 * @return The top-left corner of the reserved place, or nothing if the rectangle doesn't fit.
+		 */
+		std::optional<std::pair<uint32_t, uint32_t>> pack(uint32_t width, uint32_t height);
+
+		/*!
+		 * Frees every reserved place.
+		 */
+		void reset();
+	};
+
+	/*!
+	 * An image packed in a TextureAtlas page.
+	 */
+	struct AtlasEntry
+	{
+		/*! The page holding the image. */
+		Texture texture;
+		/*! The region of the page covered by the image. */
+		TextureRegion region;
+	};
+
+	/*!
+	 * Packs many small images into shared texture pages, so that drawing them doesn't break the sprite batch.
+	 * The entries plug into {@code Graphics::draw_image(texture, ..., region)}.
+	 *
+	 * Each image is surrounded by an extrusion of its edge pixels, then by transparent padding,
+	 * which keeps filtering from sampling the neighbour images.
+	 * Pages don't have mipmaps, the filter mode must be NEAREST or LINEAR.
+	 */
+	class IONICENGINE_API TextureAtlas
+	{
+	private:
+		struct Page
+		{
+			Texture texture;
+			SkylinePacker packer;
+		};
+
+		uint32_t _page_width, _page_height;
+		uint32_t _padding, _extrusion;
+		TextureFilterMode _filter_mode;
+		std::vector<Page> _pages;
+		ResourceStorage<AtlasEntry> _entries;
+
+		Page &new_page();
+
+	public:
+		explicit TextureAtlas(uint32_t page_width = IONIC_ATLAS_PAGE_SIZE, uint32_t page_height = IONIC_ATLAS_PAGE_SIZE,
+							  uint32_t padding = 1, uint32_t extrusion = 1, TextureFilterMode filter_mode = NEAREST);
+
+		TextureAtlas(const TextureAtlas &other) = delete;
+
+		~TextureAtlas();
+
+		uint32_t get_page_width() const;
+
+		uint32_t get_page_height() const;
+
+		uint32_t get_padding() const;
+
+		uint32_t get_extrusion() const;
+
+		size_t get_page_count() const;
+
+		const Texture &get_page(size_t index) const;
+
+		/*!
+		 * Loads an image from the resources and packs it in the atlas.
+		 * @param name The resource name of the image.
+		 * @param extension The extension of the image file.
+		 * @return The packed image, or nothing if the image cannot be loaded or is larger than a page.
+		 */
+		std::optional<AtlasEntry> load(const lambdacommon::ResourceName &name, const std::string &extension = "png");
+
+		/*!
+		 * Packs an RGBA image in the atlas. If an image with the same name was already added it is returned instead.
+		 * @param name The resource name of the image.
+		 * @param image The pixels of the image, 4 bytes per pixel, row by row.
+		 * @param width The width of the image.
+		 * @param height The height of the image.
+		 * @return The packed image, or nothing if the image is larger than a page.
+		 */
+		std::optional<AtlasEntry>
+		add(const lambdacommon::ResourceName &name, const unsigned char *image, uint32_t width, uint32_t height);
+
+		bool has(const lambdacommon::ResourceName &name) const;
+
+		bool has(ResourceHandle handle) const;
+
+		/*!
+		 * Gets a packed image.
+		 * @param handle The handle of the image.
+		 * @return A pointer to the packed image or null if there is no image with this handle.
+		 */
+		const AtlasEntry *get(ResourceHandle handle) const;
+
+		const AtlasEntry *get(const lambdacommon::ResourceName &name) const;
+
+		/*!
+		 * Deletes every page and forgets every packed image.
+		 */
+		void clear();
+	};
+}
+
+#endif //IONICENGINE_ATLAS_H
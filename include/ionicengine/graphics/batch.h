@@ -0,0 +1,242 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_BATCH_H
+#define IONICENGINE_BATCH_H
+
+#include "shader.h"
+#include "textures.h"
+#include <vector>
+
+#define IONIC_SPRITE_BATCH_MAX_SPRITES 4096
+#define IONIC_PRIMITIVE_BATCH_MAX_VERTICES 16384
+#define IONIC_SPRITE_INSTANCES_INITIAL_CAPACITY 1024
+
+namespace ionicengine
+{
+	/*!
+	 * Vertex layout used by the sprite batch, positions are already transformed into screen space.
+	 */
+	struct SpriteVertex
+	{
+		float x, y;
+		float u, v;
+		float r, g, b, a;
+	};
+
+	/*!
+	 * Vertex layout used by the primitive batch, positions are already transformed into screen space.
+	 */
+	struct ColoredVertex
+	{
+		float x, y;
+		float r, g, b, a;
+	};
+
+	/*!
+	 * Per-instance data of an instanced sprite draw, uploaded as is to the instance buffer.
+	 */
+	struct SpriteInstance
+	{
+		float x, y;
+		float width, height;
+		/*!
+		 * Rotation in radians around the center of the sprite.
+		 */
+		float rotation = 0.f;
+		float r = 1.f, g = 1.f, b = 1.f, a = 1.f;
+		TextureRegion region = TextureRegion::BASE;
+	};
+
+	/*!
+	 * Accumulates textured quads CPU-side and submits them with a single draw call.
+	 * The batch is flushed when the texture or the shader changes, when it is full or when explicitly asked.
+	 */
+	class IONICENGINE_API SpriteBatch
+	{
+	private:
+		uint32_t _vao = 0, _vbo = 0, _ebo = 0;
+		size_t _max_sprites;
+		std::vector<SpriteVertex> _vertices;
+		Shader _shader;
+		int32_t _projection_location = -1, _image_location = -1;
+		uint32_t _texture = 0;
+
+	public:
+		explicit SpriteBatch(size_t max_sprites = IONIC_SPRITE_BATCH_MAX_SPRITES);
+
+		SpriteBatch(const SpriteBatch &other) = delete;
+
+		~SpriteBatch();
+
+		/*!
+		 * Gets the maximum number of sprites submitted in one draw call.
+		 * @return The maximum number of sprites.
+		 */
+		size_t get_max_sprites() const;
+
+		/*!
+		 * Gets the number of sprites waiting to be drawn.
+		 * @return The number of pending sprites.
+		 */
+		size_t get_pending_sprites() const;
+
+		/*!
+		 * Checks whether the batch has no pending sprites.
+		 * @return True if the batch is empty, else false.
+		 */
+		bool is_empty() const;
+
+		/*!
+		 * Checks whether adding a sprite with the specified shader and texture requires a flush first.
+		 * @param shader The shader of the sprite.
+		 * @param texture The OpenGL texture ID of the sprite.
+		 * @return True if the batch must be flushed before accepting the sprite, else false.
+		 */
+		bool needs_flush(const Shader &shader, uint32_t texture) const;
+
+		/*!
+		 * Adds a quad to the batch, the vertices must be ordered top-left, top-right, bottom-left, bottom-right.
+		 * The caller is responsible of flushing the batch when {@code needs_flush} returns true.
+		 * @param shader The shader to use.
+		 * @param texture The OpenGL texture ID to sample.
+		 * @param quad The four vertices of the quad.
+		 */
+		void push(const Shader &shader, uint32_t texture, const SpriteVertex quad[4]);
+
+		/*!
+		 * Draws every pending sprite in one draw call.
+		 * @param projection The projection matrix.
+		 * @return True if a draw call was issued, else false.
+		 */
+		bool flush(const glm::mat4 &projection);
+	};
+
+	/*!
+	 * Draws any number of sprites sharing a texture with one instanced draw call over a unit quad.
+	 * The instance buffer grows to fit the largest draw and is orphaned before each upload.
+	 */
+	class IONICENGINE_API SpriteInstancer
+	{
+	private:
+		uint32_t _vao = 0, _vbo = 0;
+		size_t _capacity;
+		Shader _shader;
+		int32_t _projection_location = -1, _image_location = -1, _color_location = -1;
+
+	public:
+		/*!
+		 * Creates the instance buffer.
+		 * @param quad_vbo The vertex buffer of the unit quad, drawn as a triangle strip.
+		 * @param capacity The initial number of instances the buffer can hold.
+		 */
+		explicit SpriteInstancer(uint32_t quad_vbo, size_t capacity = IONIC_SPRITE_INSTANCES_INITIAL_CAPACITY);
+
+		SpriteInstancer(const SpriteInstancer &other) = delete;
+
+		~SpriteInstancer();
+
+		/*!
+		 * Gets the number of instances the buffer holds without growing.
+		 * @return The capacity of the instance buffer.
+		 */
+		size_t get_capacity() const;
+
+		/*!
+		 * Draws the instances in one draw call.
+		 * @param shader The instanced sprite shader.
+		 * @param texture The OpenGL texture ID to sample.
+		 * @param projection The projection matrix, including the transformation of the instances.
+		 * @param color The color multiplied with the color of every instance.
+		 * @param instances The instances to draw.
+		 * @param count The number of instances.
+		 * @return True if a draw call was issued, else false.
+		 */
+		bool draw(const Shader &shader, uint32_t texture, const glm::mat4 &projection, const lambdacommon::Color &color,
+				  const SpriteInstance *instances, size_t count);
+	};
+
+	/*!
+	 * Accumulates solid triangles and lines with per-vertex color into one vertex stream.
+	 * A flush uploads the stream once and issues at most one draw call per primitive type, triangles first.
+	 */
+	class IONICENGINE_API PrimitiveBatch
+	{
+	private:
+		uint32_t _vao = 0, _vbo = 0;
+		size_t _max_vertices;
+		std::vector<ColoredVertex> _triangles;
+		std::vector<ColoredVertex> _lines;
+		Shader _shader;
+		int32_t _projection_location = -1;
+
+	public:
+		explicit PrimitiveBatch(size_t max_vertices = IONIC_PRIMITIVE_BATCH_MAX_VERTICES);
+
+		PrimitiveBatch(const PrimitiveBatch &other) = delete;
+
+		~PrimitiveBatch();
+
+		/*!
+		 * Gets the maximum number of vertices submitted in one flush.
+		 * @return The maximum number of vertices.
+		 */
+		size_t get_max_vertices() const;
+
+		/*!
+		 * Checks whether the batch has no pending primitives.
+		 * @return True if the batch is empty, else false.
+		 */
+		bool is_empty() const;
+
+		/*!
+		 * Checks whether lines are waiting to be drawn.
+		 * Triangles are drawn before lines, so triangles added after lines require a flush to stay on top.
+		 * @return True if lines are pending, else false.
+		 */
+		bool has_lines() const;
+
+		/*!
+		 * Checks whether the specified amount of vertices still fits in the batch.
+		 * @param count The amount of vertices.
+		 * @return True if the vertices fit, else false.
+		 */
+		bool can_fit(size_t count) const;
+
+		/*!
+		 * Gets the number of vertices waiting to be drawn, triangles and lines together.
+		 * @return The number of pending vertices.
+		 */
+		size_t get_pending_vertices() const;
+
+		/*!
+		 * Adds triangles to the batch.
+		 * @param vertices The vertices, three per triangle.
+		 * @param count The number of vertices.
+		 */
+		void push_triangles(const ColoredVertex *vertices, size_t count);
+
+		/*!
+		 * Adds lines to the batch.
+		 * @param vertices The vertices, two per line.
+		 * @param count The number of vertices.
+		 */
+		void push_lines(const ColoredVertex *vertices, size_t count);
+
+		/*!
+		 * Draws every pending primitive.
+		 * @param shader The shader to use.
+		 * @param projection The projection matrix.
+		 * @return The number of draw calls issued.
+		 */
+		uint32_t flush(Shader &shader, const glm::mat4 &projection);
+	};
+}
+
+#endif //IONICENGINE_BATCH_H
@@ -0,0 +1,127 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_COMMANDS_H
+#define IONICENGINE_COMMANDS_H
+
+#include "../includes.h"
+#include <unordered_map>
+#include <vector>
+
+#define IONIC_COMMAND_CELL_SIZE 64    // Size in pixels of the cells used to find overlapping commands.
+#define IONIC_COMMAND_UNIQUE_BATCH UINT64_MAX    // Batch state of commands never merged with another one.
+
+namespace ionicengine
+{
+	enum RenderCommandType
+	{
+		COMMAND_SPRITE,
+		COMMAND_TRIANGLES,
+		COMMAND_LINES,
+		COMMAND_INSTANCES
+	};
+
+	/*!
+	 * A recorded draw, the vertices or instances it refers to are stored by the graphics which recorded it.
+	 */
+	struct RenderCommand
+	{
+		/*!
+		 * Layer, depth then batch from the most significant bits.
+		 */
+		uint64_t key;
+		RenderCommandType type;
+		/*!
+		 * The range of the command in the storage of its type.
+		 */
+		uint32_t first, count;
+	};
+
+	/*!
+	 * Records draw commands with a sort key and orders them to need as few batches as possible.
+	 *
+	 * The depth of a command is the lowest one keeping it above every earlier command it overlaps in its layer:
+	 * the same depth as an overlapped command of the same batch, one more than an overlapped command of another batch.
+	 * Sorting by layer, depth then batch therefore groups the draws by state without changing what overlapping
+	 * blended draws look like. Overlaps are found on a grid, a command touching a cell overlaps every command in it.
+	 */
+	class IONICENGINE_API CommandQueue
+	{
+	private:
+		struct Cell
+		{
+			// 0 for an empty cell, else the highest depth in the cell plus one.
+			uint32_t depth;
+			// The batch at the highest depth, mixed when several batches share it.
+			uint32_t batch;
+		};
+
+		struct LayerGrid
+		{
+			uint8_t layer;
+			std::vector<Cell> cells;
+		};
+
+		uint32_t _columns = 1, _rows = 1;
+		std::vector<LayerGrid> _grids;
+		std::vector<RenderCommand> _commands;
+		std::unordered_map<uint64_t, uint32_t> _batches;
+		// Batches are numbered in order of first use.
+		uint32_t _next_batch = 0;
+
+		std::vector<Cell> &get_grid(uint8_t layer);
+
+	public:
+		/*!
+		 * Sets the size of the area covered by the commands, commands outside of it are clamped to its edges.
+		 * @param width The width in pixels.
+		 * @param height The height in pixels.
+		 */
+		void set_bounds(uint32_t width, uint32_t height);
+
+		/*!
+		 * Records a command.
+		 * @param layer The layer of the command, higher layers are drawn over lower ones.
+		 * @param state The render state of the command, commands with the same state can be drawn in one batch.
+		 * 				{@code IONIC_COMMAND_UNIQUE_BATCH} is never merged.
+		 * @param min_x The left of the screen space bounds.
+		 * @param min_y The top of the screen space bounds.
+		 * @param max_x The right of the screen space bounds.
+		 * @param max_y The bottom of the screen space bounds.
+		 * @param type The type of the command.
+		 * @param first The index of the first element of the command.
+		 * @param count The number of elements of the command.
+		 */
+		void push(uint8_t layer, uint64_t state, float min_x, float min_y, float max_x, float max_y,
+				  RenderCommandType type, uint32_t first, uint32_t count);
+
+		/*!
+		 * Sorts the recorded commands by their key, commands with equal keys keep their recording order.
+		 * @return The sorted commands.
+		 */
+		const std::vector<RenderCommand> &sort();
+
+		size_t size() const;
+
+		bool is_empty() const;
+
+		/*!
+		 * Gets the number of distinct batches recorded, every command with a unique batch counts as one.
+		 * @return The number of batches.
+		 */
+		size_t get_batch_count() const;
+
+		/*!
+		 * Removes every command, the storage is kept for the next frame.
+		 */
+		void clear();
+	};
+}
+
+#endif //IONICENGINE_COMMANDS_H
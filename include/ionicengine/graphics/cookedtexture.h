@@ -0,0 +1,145 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_COOKEDTEXTURE_H
+#define IONICENGINE_COOKEDTEXTURE_H
+
+#include "../mappedfile.h"
+
+#define IONIC_COOKED_TEXTURE_MAGIC 0x58455449u    // "ITEX" read as a little-endian integer.
+#define IONIC_COOKED_TEXTURE_VERSION 2
+#define IONIC_COOKED_TEXTURE_EXTENSION "itex"
+
+namespace ionicengine
+{
+	enum CookedTextureFormat : uint32_t
+	{
+		COOKED_RGBA8 = 0,
+		/*! Opaque block-compressed color, 8 bytes per 4x4 block. */
+		COOKED_BC1 = 1,
+		/*! Block-compressed color with interpolated alpha, 16 bytes per 4x4 block. */
+		COOKED_BC3 = 2
+	};
+
+	/*!
+	 * Header at the start of a cooked texture file, followed by one CookedMipLevel per mip level, then the pixels.
+	 * The file is written with the byte order of the host, every supported platform is little-endian.
+	 */
+	struct CookedTextureHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t format;
+		uint32_t width;
+		uint32_t height;
+		/*! The number of channels of the source image. */
+		uint32_t channels;
+		uint32_t mip_count;
+		/*! The CookFlags of the options the texture was cooked with. */
+		uint32_t cook_flags;
+		/*! The modification time of the source image when cooked, in seconds. */
+		int64_t source_mtime;
+		/*! The size of the source image when cooked, in bytes. */
+		uint64_t source_size;
+	};
+
+	struct CookedMipLevel
+	{
+		uint32_t width;
+		uint32_t height;
+		/*! The offset of the pixels from the start of the file. */
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	enum CookFlags : uint32_t
+	{
+		COOK_COMPRESS = 1,
+		COOK_MIPMAPS = 2
+	};
+
+	struct CookOptions
+	{
+		/*! Compresses the texture with BC1, or BC3 when the image has transparent pixels. */
+		bool compress = false;
+		/*! Stores the full mip chain, else only the base level. */
+		bool mipmaps = true;
+
+		uint32_t get_flags() const;
+	};
+
+	/*!
+	 * A validated and memory-mapped cooked texture file.
+	 */
+	class IONICENGINE_API CookedTexture
+	{
+	private:
+		MappedFile _file;
+		const CookedTextureHeader *_header = nullptr;
+		const CookedMipLevel *_levels = nullptr;
+
+	public:
+		/*!
+		 * Maps and validates the cooked texture at the specified path.
+		 * @param path The path of the cooked texture.
+		 * @return True if the file is a valid cooked texture, else false.
+		 */
+		bool open(const std::string &path);
+
+		const CookedTextureHeader &get_header() const;
+
+		const CookedMipLevel &get_level(uint32_t level) const;
+
+		/*!
+		 * Gets the pixels of the specified mip level, straight from the mapping.
+		 * @param level The mip level.
+		 * @return The pixels.
+		 */
+		const unsigned char *get_level_data(uint32_t level) const;
+
+		/*!
+		 * Checks whether the cooked texture was cooked from the current version of the specified source.
+		 * @param source_path The path of the source image.
+		 * @return True if the source didn't change since the cooking, else false.
+		 */
+		bool is_up_to_date(const std::string &source_path) const;
+
+		/*!
+		 * Checks whether the texture was cooked with the specified options.
+		 * @param options The cooking options.
+		 * @return True if the options match the ones of the cooking, else false.
+		 */
+		bool was_cooked_with(const CookOptions &options) const;
+
+		explicit operator bool() const;
+	};
+
+	namespace texture
+	{
+		/*!
+		 * Gets the extension of the cooked texture of a source image, the extension of the source is kept so that
+		 * images differing only by their extension don't share a cooked texture.
+		 * @param extension The extension of the source image, e.g. "png".
+		 * @return The extension of the cooked texture, e.g. "png.itex".
+		 */
+		extern std::string IONICENGINE_API get_cooked_extension(const std::string &extension);
+
+		/*!
+		 * Cooks an image: decodes it, builds its mip chain, optionally compresses it and writes it as a cooked texture.
+		 * @param source_path The path of the image to cook.
+		 * @param output_path The path of the cooked texture to write.
+		 * @param options The cooking options.
+		 * @return True if the texture was cooked, else false.
+		 */
+		extern bool IONICENGINE_API
+		cook(const std::string &source_path, const std::string &output_path, const CookOptions &options = {});
+	}
+}
+
+#endif //IONICENGINE_COOKEDTEXTURE_H
@@ -0,0 +1,171 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_DRAWLIST_H
+#define IONICENGINE_DRAWLIST_H
+
+#include "graphics.h"
+#include <memory>
+#include <vector>
+
+namespace ionicengine
+{
+	enum DrawCommandType
+	{
+		DRAW_COLOR,
+		DRAW_TRANSFORM,
+		DRAW_LAYER,
+		DRAW_BLEND_MODE,
+		DRAW_FLUSH,
+		DRAW_LINE,
+		DRAW_QUAD,
+		DRAW_QUAD_OUTLINE,
+		DRAW_IMAGE,
+		DRAW_INSTANCES,
+		DRAW_TEXT
+	};
+
+	/*!
+	 * A recorded graphics call, the index refers to the storage of its type in the draw list.
+	 */
+	struct DrawCommand
+	{
+		DrawCommandType type;
+		uint32_t index;
+	};
+
+	/*!
+	 * The graphics calls of a frame, recorded on one thread to be replayed on another one.
+	 * Everything a command needs is copied or shared, so the list stays valid whatever the recording thread does next.
+	 */
+	class IONICENGINE_API DrawList
+	{
+	private:
+		struct RecordedImage
+		{
+			// Images drawn by handle are resolved when replayed, the texture may be uploaded in between.
+			std::optional<Texture> texture;
+			ResourceHandle handle;
+			float x, y, width, height;
+			TextureRegion region;
+		};
+
+		struct RecordedInstances
+		{
+			Texture texture;
+			size_t first, count;
+		};
+
+		struct RecordedText
+		{
+			std::shared_ptr<const TextLayout> layout;
+			int x, y;
+			uint32_t max_height;
+			float scale;
+		};
+
+		Dimension2D_u32 _framebuffer_size{0, 0};
+		Dimension2D_u32 _viewport_size{0, 0};
+		lambdacommon::Color _background_color = lambdacommon::Color::COLOR_BLACK;
+		std::vector<DrawCommand> _commands;
+		std::vector<lambdacommon::Color> _colors;
+		std::vector<glm::mat4> _transforms;
+		std::vector<glm::vec4> _rectangles;
+		std::vector<RecordedImage> _images;
+		std::vector<RecordedInstances> _instanced_draws;
+		std::vector<SpriteInstance> _instances;
+		std::vector<RecordedText> _texts;
+
+		friend class RecordingGraphics;
+
+	public:
+		const Dimension2D_u32 &get_framebuffer_size() const;
+
+		/*!
+		 * Gets the size in pixels of the OpenGL viewport the list is drawn in.
+		 * @return The size of the viewport.
+		 */
+		const Dimension2D_u32 &get_viewport_size() const;
+
+		void set_viewport_size(const Dimension2D_u32 &size);
+
+		const lambdacommon::Color &get_background_color() const;
+
+		void set_background_color(const lambdacommon::Color &color);
+
+		size_t size() const;
+
+		bool is_empty() const;
+
+		/*!
+		 * Replays the recorded calls on the specified graphics, then flushes it.
+		 * @param graphics The graphics to draw with.
+		 */
+		void replay(Graphics *graphics) const;
+
+		/*!
+		 * Removes every command, the storage is kept for the next frame.
+		 */
+		void clear();
+	};
+
+	/*!
+	 * Graphics recording its calls into a draw list instead of drawing, it never calls OpenGL.
+	 * The color, the transformation, the layer and the blend mode are recorded only when a draw uses them after a change.
+	 */
+	class IONICENGINE_API RecordingGraphics : public Graphics
+	{
+	private:
+		DrawList *_list = nullptr;
+		lambdacommon::Color _recorded_color = lambdacommon::Color::COLOR_WHITE;
+		glm::mat4 _recorded_transform{1.0f};
+		uint8_t _recorded_layer = 0;
+		BlendMode _recorded_blend_mode = BLEND_ALPHA;
+		bool _state_recorded = false;
+
+		void record_state();
+
+		void record(DrawCommandType type, size_t index);
+
+	public:
+		using Graphics::draw_image;
+		using Graphics::draw_image_instanced;
+		using Graphics::draw_text;
+
+		explicit RecordingGraphics(const Dimension2D_u32 &framebuffer_size);
+
+		/*!
+		 * Starts recording a frame into the specified list, which is cleared first.
+		 * @param list The list to record into.
+		 */
+		void begin(DrawList &list);
+
+		void flush() override;
+
+		void set_color(const lambdacommon::Color &color) override;
+
+		void draw_line_2d(float x, float y, float x2, float y2) override;
+
+		void draw_quad(float x, float y, float width, float height) override;
+
+		void draw_quad_outline(float x, float y, float width, float height) override;
+
+		void draw_image(ResourceHandle texture, float x, float y, float width, float height,
+						const TextureRegion &region) override;
+
+		void draw_image(const Texture &texture, float x, float y, float width, float height,
+						const TextureRegion &region) override;
+
+		void draw_image_instanced(const Texture &texture, const SpriteInstance *instances, size_t count) override;
+
+		void draw_text(const TextLayout &layout, int x, int y, uint32_t maxHeight, float scale) override;
+	};
+}
+
+#endif //IONICENGINE_DRAWLIST_H
@@ -11,22 +11,65 @@
 #define IONICENGINE_FONT_H
 
 #include "../includes.h"
+#include "../resource.h"
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include <glm/glm.hpp>
+#include <memory>
 #include <optional>
-#include <map>
 
-#define IONIC_MAX_GLYPHS 10023
+// Size of the atlas pages the glyphs are rasterized into.
+#define IONIC_FONT_PAGE_SIZE 1024
+// Number of pages a font keeps before evicting the least recently used one.
+#define IONIC_FONT_MAX_PAGES 4
+// Codepoints below this limit (ASCII and Latin-1) are looked up by direct indexing.
+#define IONIC_FONT_DIRECT_GLYPHS 256
+// Pixel size the glyphs of the signed distance field fonts are rasterized at.
+#define IONIC_FONT_SDF_SIZE 48
+// Distance in pixels, at the rasterization size, covered by the signed distance fields on each side of the edges.
+#define IONIC_FONT_SDF_SPREAD 6
+// Smallest amount of glyphs rendered by one task of the parallel rasterization.
+#define IONIC_FONT_GLYPHS_PER_TASK 32
+
+#define IONIC_FONT_CACHE_MAGIC 0x434E4649u // "IFNC"
+#define IONIC_FONT_CACHE_VERSION 1
+#define IONIC_FONT_CACHE_EXTENSION "ifc"
+#define IONIC_FONT_CACHE_DIRECTORY "cache/fonts"
 
 namespace ionicengine
 {
 	using namespace std::rel_ops;
 
+	namespace utf8
+	{
+		/*!
+		 * Decodes the codepoint starting at the specified offset and moves the offset past it.
+		 * Invalid or truncated sequences decode to U+FFFD and skip a single byte.
+		 * @param text The UTF-8 encoded text.
+		 * @param offset The byte offset of the codepoint, must be lower than the size of the text.
+		 * @return The decoded codepoint.
+		 */
+		extern char32_t IONICENGINE_API decode(const std::string &text, size_t &offset);
+
+		/*!
+		 * Appends the UTF-8 encoding of the specified codepoint to a string.
+		 * @param text The string to append to.
+		 * @param codepoint The codepoint to encode.
+		 */
+		extern void IONICENGINE_API append(std::string &text, char32_t codepoint);
+
+		/*!
+		 * Gets the offset of the first byte of the codepoint preceding the specified offset.
+		 * @param text The UTF-8 encoded text.
+		 * @param offset The byte offset, must be greater than 0.
+		 * @return The offset of the previous codepoint.
+		 */
+		extern size_t IONICENGINE_API previous(const std::string &text, size_t offset);
+	}
+
 	struct Character
 	{
 		uint32_t codepoint;
-		uint32_t texture_id;
 		glm::ivec2 size;
 		// Coords of the glyph in the texture atlas.
 		glm::ivec2 position;
@@ -34,39 +77,118 @@ namespace ionicengine
 		glm::ivec2 bearing;
 		// X advance when rendering.
 		uint32_t advance;
+		// Index of the font atlas page holding the glyph.
+		uint32_t page;
 
 		bool operator==(const Character &rhs) const;
 
 		bool operator<(const Character &rhs) const;
 	};
 
+	/*!
+	 * The way the glyphs of a font are rasterized.
+	 */
+	enum FontMode
+	{
+		/*! Coverage bitmaps at the size of the font, crisp at that size only. */
+		FONT_BITMAP,
+		/*! Signed distance fields at IONIC_FONT_SDF_SIZE, crisp at any size with the text_sdf shader. */
+		FONT_SDF
+	};
+
+	/*!
+	 * The face and the glyph cache of a loaded font, shared by every copy of the font.
+	 */
+	class FontData;
+
 	class Font
 	{
 	private:
-		uint32_t _texture_id{};
-		std::pair<uint32_t, uint32_t> _texture_size;
-		std::map<char, Character> _chars;
+		std::shared_ptr<FontData> _data;
+		std::pair<uint32_t, uint32_t> _texture_size{IONIC_FONT_PAGE_SIZE, IONIC_FONT_PAGE_SIZE};
 		uint32_t _size;
 		uint32_t _tab_size{4};
+		float _scale{1.f};
+		int32_t _max_bearing_y{0};
+		uint32_t _height{0};
 
 	public:
-		Font(uint32_t textureId, std::pair<uint32_t, uint32_t> textureSize, const std::map<char, Character> &charactersMap, uint32_t size,
-			 uint32_t tabSize = 4);
+		Font(std::shared_ptr<FontData> data, uint32_t size, uint32_t tabSize = 4);
 
 		Font(const Font &font);
 
 		Font(Font &&font) noexcept;
 
-		uint32_t get_texture_id() const;
+		/*!
+		 * Gets the face and the glyph cache shared by the copies of the font.
+		 * @return The shared font data.
+		 */
+		const FontData *get_data() const;
 
+		/*!
+		 * Gets a copy of the font drawn at another size, sharing the same glyphs.
+		 * Only signed distance field fonts stay crisp at a size different from their rasterization size.
+		 * @param size The size of the copy.
+		 * @return The font at the specified size.
+		 */
+		Font with_size(uint32_t size) const;
+
+		/*!
+		 * Checks whether the glyphs are signed distance fields.
+		 * @return True if the font must be drawn with the text_sdf shader, else false.
+		 */
+		bool is_sdf() const;
+
+		/*!
+		 * Gets the ratio between the size of the font and the size its glyphs are rasterized at.
+		 * The character metrics are in rasterization pixels and must be multiplied by this scale.
+		 * @return The scale of the glyphs.
+		 */
+		float get_scale() const;
+
+		/*!
+		 * Gets the horizontal advance of a character at the size of the font.
+		 * @param character The character.
+		 * @return The advance in pixels.
+		 */
+		float get_advance(const Character &character) const;
+
+		/*!
+		 * Gets the size of the atlas pages holding the glyphs.
+		 * @return The size of a page.
+		 */
 		const std::pair<uint32_t, uint32_t> &get_texture_size() const;
 
 		/*!
-		 * Gets the character's data of the specified character.
-		 * @param c The specified character.
-		 * @return The data of the specified character.
+		 * Gets the character's data of the specified codepoint.
+		 * The glyph is rasterized into the font atlas the first time it is requested.
+		 * The data is copied, a later request may rasterize over or evict the stored glyph.
+		 * @param codepoint The specified codepoint.
+		 * @return The data of the specified codepoint, or an empty character if the font doesn't provide it.
 		 */
-		Character get_character(char c) const;
+		Character get_character(char32_t codepoint) const;
+
+		/*!
+		 * Gets the OpenGL texture of a page of the font atlas.
+		 * The glyphs rasterized into the page since the last call are uploaded first.
+		 * @param page The index of the page, as given by a character.
+		 * @return The texture of the page.
+		 */
+		uint32_t get_page_texture(uint32_t page) const;
+
+		/*!
+		 * Rasterizes every glyph of a codepoint range not rasterized yet, in parallel on the worker pool.
+		 * Only the atlas upload is left to the GL thread, it happens when the glyphs are first drawn.
+		 * @param first The first codepoint of the range.
+		 * @param last The last codepoint of the range, included.
+		 */
+		void preload(char32_t first, char32_t last) const;
+
+		/*!
+		 * Gets the top bearing of the tallest latin capital letter, used to align glyphs on a common baseline.
+		 * @return The maximum top bearing, at the size of the font.
+		 */
+		int32_t get_max_bearing_y() const;
 
 		/*!
 		 * Gets the size of the font.
@@ -87,7 +209,7 @@ namespace ionicengine
 		void set_tab_size(uint32_t tabSize);
 
 		/*!
-		 * Gets the length of a string in pixels.
+		 * Gets the length of a string in pixels, the layout of the string is taken from the layout cache.
 		 * @param text Text to measure.
 		 * @return The length of the specified string.
 		 */
@@ -111,7 +233,7 @@ namespace ionicengine
 		std::string trim_text_to_length_dotted(const std::string &input, uint32_t length) const;
 
 		/*!
-		 * Gets the height a=of a string in pixels.
+		 * Gets the height of a string in pixels, the layout of the string is taken from the layout cache.
 		 * @param text Text to measure.
 		 * @return The height of the specified string.
 		 */
@@ -131,8 +253,10 @@ namespace ionicengine
 	class FontManager
 	{
 	private:
-		FT_Library ft;
+		std::shared_ptr<FT_LibraryRec_> _library;
 		lambdacommon::ResourceName default_font{"liberation:fonts/sans"};
+		ResourceHandle default_font_handle;
+		std::string _cache_directory{IONIC_FONT_CACHE_DIRECTORY};
 
 	public:
 		FontManager();
@@ -141,6 +265,25 @@ namespace ionicengine
 
 		void shutdown();
 
+		/*!
+		 * Marks the start of a new frame, the atlas pages used during the current or the previous frame are never evicted.
+		 */
+		void new_frame();
+
+		/*!
+		 * Gets the directory of the font rasterization caches.
+		 * @return The cache directory, empty if the cache is disabled.
+		 */
+		const std::string &get_cache_directory() const;
+
+		/*!
+		 * Sets the directory of the font rasterization caches, the fonts loaded afterwards use it.
+		 * A cache file is keyed by the hash of the font file and the rasterization settings,
+		 * it is written when the font is released if new glyphs were rasterized.
+		 * @param directory The cache directory, empty to disable the cache.
+		 */
+		void set_cache_directory(const std::string &directory);
+
 		/*!
 		 * Gets the default font name.
 		 * @return The default font name.
@@ -160,34 +303,46 @@ namespace ionicengine
 		 */
 		Font *get_font(const lambdacommon::ResourceName &font_name) const;
 
+		/*!
+		 * Gets a loaded font.
+		 * @param font The handle of the font.
+		 * @return The pointer of the font.
+		 */
+		Font *get_font(ResourceHandle font) const;
+
 		/*!
 		 * Loads the font with the specified resource name.
 		 * @param font_name The font's resource name.
 		 * @param size The font size to load.
+		 * @param mode The way the glyphs are rasterized.
 		 * @return An optional Font.
 		 */
-		std::optional<Font> load_font(const lambdacommon::ResourceName &font_name, uint32_t size) const;
+		std::optional<Font> load_font(const lambdacommon::ResourceName &font_name, uint32_t size,
+									  FontMode mode = FONT_BITMAP) const;
 
 		/*!
 		 * Loads the font at the specified path.
 		 * @param font_name The font's resource name.
 		 * @param path The path where the font file resides.
 		 * @param size The font size to load.
+		 * @param mode The way the glyphs are rasterized.
 		 * @return An optional Font.
 		 */
 		std::optional<Font> load_font(const lambdacommon::ResourceName &font_name,
 									  const lambdacommon::fs::FilePath &path,
-									  uint32_t size) const;
+									  uint32_t size, FontMode mode = FONT_BITMAP) const;
 
 		/*!
 		 * Loads the font at the specified path.
 		 * @param font_name The font's resource name.
 		 * @param path The path where the font file resides.
 		 * @param size The font size to load.
+		 * @param mode The way the glyphs are rasterized.
 		 * @return An optional Font.
 		 */
 		std::optional<Font>
-		load_font(const lambdacommon::ResourceName &font_name, const std::string &path, uint32_t size) const;
+		load_font(const lambdacommon::ResourceName &font_name, const std::string &path, uint32_t size,
+				  FontMode mode = FONT_BITMAP) const;
 	};
 }
 
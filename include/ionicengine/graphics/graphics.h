@@ -10,7 +10,10 @@
 #ifndef IONICENGINE_GRAPHICS_H
 #define IONICENGINE_GRAPHICS_H
 
+#include "batch.h"
+#include "commands.h"
 #include "font.h"
+#include "textlayout.h"
 #include "textures.h"
 #include "shader.h"
 #include "utils.h"
@@ -27,6 +30,36 @@ namespace ionicengine
 			quad_outline_vao = 0, quad_outline_vbo = 0,
 			texture_vao = 0, texture_vbo = 0;
 
+	enum BlendMode
+	{
+		/*!
+		 * The colors are multiplied by their alpha when blended, the default.
+		 */
+		BLEND_ALPHA,
+		/*!
+		 * The colors are already multiplied by their alpha, e.g. the content of a render target.
+		 */
+		BLEND_PREMULTIPLIED
+	};
+
+	/*!
+	 * Counts the work a graphics sends to the driver.
+	 */
+	struct RenderStats
+	{
+		uint64_t draw_calls = 0;
+		/*! The number of shader program changes which reached the driver. */
+		uint64_t program_switches = 0;
+		/*! The number of texture binds which reached the driver. */
+		uint64_t texture_binds = 0;
+		/*! The number of vertex or instance streams uploaded to a buffer. */
+		uint64_t buffer_uploads = 0;
+		/*! The number of vertices drawn, every instance counts its four vertices. */
+		uint64_t vertices = 0;
+
+		RenderStats &operator+=(const RenderStats &other);
+	};
+
 	class IONICENGINE_API Graphics
 	{
 	protected:
@@ -34,6 +67,11 @@ namespace ionicengine
 		Dimension2D_u32 _framebuffer_size;
 		glm::mat4 _projection2d;
 		glm::mat4 _transform{1.0f};
+		bool _batching = true;
+		uint8_t _layer = 0;
+		BlendMode _blend_mode = BLEND_ALPHA;
+		// The statistics of the frame being drawn, of the last ended frame and of every ended frame.
+		RenderStats _stats, _frame_stats, _total_stats;
 
 	public:
 		Graphics(const Dimension2D_u32 &framebufferSize);
@@ -79,6 +117,67 @@ namespace ionicengine
 		 */
 		void update_framebuffer_size(uint32_t width, uint32_t height);
 
+		/*!
+		 * Checks whether the draw calls are batched or not.
+		 * @return True if the draw calls are batched, else false.
+		 */
+		bool is_batching() const;
+
+		/*!
+		 * Sets whether the draw calls are batched or not.
+		 * When batching is disabled, every draw is submitted immediately.
+		 * @param batching True if the draw calls are batched, else false.
+		 */
+		void set_batching(bool batching);
+
+		/*!
+		 * Gets the layer of the next draws.
+		 * @return The layer.
+		 */
+		uint8_t get_layer() const;
+
+		/*!
+		 * Sets the layer of the next draws.
+		 * Graphics sorting their draws draw higher layers over lower ones, the others draw in call order.
+		 * @param layer The layer.
+		 */
+		void set_layer(uint8_t layer);
+
+		BlendMode get_blend_mode() const;
+
+		/*!
+		 * Sets how the next draws are blended, the pending draws are flushed first when it changes.
+		 * @param blend_mode The blend mode.
+		 */
+		void set_blend_mode(BlendMode blend_mode);
+
+		/*!
+		 * Gets the statistics of the last ended frame.
+		 * @return The statistics of the last frame.
+		 */
+		const RenderStats &get_frame_stats() const;
+
+		/*!
+		 * Gets the statistics summed over every ended frame since the creation of the graphics or the last reset.
+		 * @return The running totals.
+		 */
+		const RenderStats &get_total_stats() const;
+
+		/*!
+		 * Ends the statistics of the current frame and adds them to the totals, called by the ScreenManager after each
+		 * frame once the graphics is flushed.
+		 */
+		void end_frame_stats();
+
+		void reset_total_stats();
+
+		/*!
+		 * Submits every pending batched draw.
+		 * It is called at the end of each frame, and must be called before doing raw OpenGL calls.
+		 * Blending and face culling are disabled once the draws are submitted.
+		 */
+		virtual void flush();
+
 		/*!
 		 * Sets the color of the objects to draw.
 		 * @param color The color to use.
@@ -90,6 +189,14 @@ namespace ionicengine
 		 */
 		void reset_transform();
 
+		const glm::mat4 &get_transform() const;
+
+		/*!
+		 * Replaces the transformation matrix.
+		 * @param transform The new transformation.
+		 */
+		void set_transform(const glm::mat4 &transform);
+
 		void translate(int x, int y, int z = 0);
 
 		void translate(float x, float y, float z = 0.0f);
@@ -162,6 +269,8 @@ namespace ionicengine
 
 		/*!
 		 * Draws a texture in 2D.
+		 * The name is looked up on every call, a texture drawn every frame should be drawn by its handle,
+		 * resolved once with {@code resource::intern}.
 		 * @param texture The texture to draw.
 		 * @param x The X coordinate of the texture.
 		 * @param y The Y coordinate of the texture.
@@ -184,6 +293,30 @@ namespace ionicengine
 		void draw_image(const lambdacommon::ResourceName &texture, float x, float y, float width, float height,
 						const TextureRegion &region = TextureRegion::BASE);
 
+		/*!
+		 * Draws a texture in 2D.
+		 * @param texture The handle of the texture to draw.
+		 * @param x The X coordinate of the texture.
+		 * @param y The Y coordinate of the texture.
+		 * @param width The width.
+		 * @param height The height.
+		 * @param region The region of the texture to draw.
+		 */
+		void draw_image(ResourceHandle texture, int x, int y, uint32_t width, uint32_t height,
+						const TextureRegion &region = TextureRegion::BASE);
+
+		/*!
+		 * Draws a texture in 2D, nothing is drawn if no texture is registered with the handle.
+		 * @param texture The handle of the texture to draw.
+		 * @param x The X coordinate of the texture.
+		 * @param y The Y coordinate of the texture.
+		 * @param width The width.
+		 * @param height The height.
+		 * @param region The region of the texture to draw.
+		 */
+		virtual void draw_image(ResourceHandle texture, float x, float y, float width, float height,
+								const TextureRegion &region = TextureRegion::BASE);
+
 		/*!
 		 * Draws a texture in 2D.
 		 * @param texture The texture to draw.
@@ -208,16 +341,46 @@ namespace ionicengine
 		virtual void draw_image(const Texture &texture, float x, float y, float width, float height,
 								const TextureRegion &region = TextureRegion::BASE) = 0;
 
+		/*!
+		 * Draws many sprites of the same texture in one draw call.
+		 * The pending batched draws are submitted first.
+		 * @param texture The texture to draw.
+		 * @param instances The sprites to draw.
+		 */
+		void draw_image_instanced(const Texture &texture, const std::vector<SpriteInstance> &instances);
+
+		/*!
+		 * Draws many sprites of the same texture in one draw call.
+		 * The pending batched draws are submitted first.
+		 * @param texture The texture to draw.
+		 * @param instances The sprites to draw.
+		 * @param count The number of sprites.
+		 */
+		virtual void draw_image_instanced(const Texture &texture, const SpriteInstance *instances, size_t count) = 0;
+
 		/*!
 		 * Draws text with the specified font, at the specified position.
+		 * The layout of the text is taken from the layout cache.
 		 * @param font The font to use.
 		 * @param x The x position of the text.
 		 * @param y The y position of the text.
 		 * @param text The text to draw.
+		 * @param maxWidth The width the lines are wrapped at, 0 to only break lines on line feeds.
+		 * @param maxHeight The height below which lines are not drawn, 0 to draw every line.
+		 * @param scale The scale of the text.
+		 */
+		void draw_text(const Font &font, int x, int y, const std::string &text, uint32_t maxWidth = 0,
+					   uint32_t maxHeight = 0, float scale = 1.0);
+
+		/*!
+		 * Draws laid out text at the specified position.
+		 * @param layout The layout of the text.
+		 * @param x The x position of the text.
+		 * @param y The y position of the text.
+		 * @param maxHeight The height below which lines are not drawn, 0 to draw every line.
 		 * @param scale The scale of the text.
 		 */
-		virtual void draw_text(const Font &font, int x, int y, const std::string &text, uint32_t maxWidth = 0,
-							   uint32_t maxHeight = 0, float scale = 1.0) = 0;
+		virtual void draw_text(const TextLayout &layout, int x, int y, uint32_t maxHeight = 0, float scale = 1.0) = 0;
 	};
 
 	//typedef Graphics* (*newGraphicsFunction)(const glm::mat4 &projection);
@@ -228,7 +391,6 @@ namespace ionicengine
 	private:
 		std::map<lambdacommon::ResourceName, newGraphicsFunction> _graphics;
 		lambdacommon::ResourceName _graphics_used;
-		uint32_t vao = 0, vbo = 0, framebuffer = 0, textureColorBuffer = 0, rbo = 0;
 
 	public:
 		GraphicsManager();
@@ -19,12 +19,26 @@ namespace ionicengine
 	{
 	protected:
 		lambdacommon::Color background_color = lambdacommon::Color::COLOR_BLACK;
+		bool dirty = true;
 
 	public:
 		uint32_t width{}, height{};
 
 		virtual ~Gui() = default;
 
+		/*!
+		 * Checks whether the gui changed since it was last drawn or not.
+		 * @return True if the gui must be drawn again, else false.
+		 */
+		virtual bool is_dirty() const;
+
+		/*!
+		 * Sets whether the gui changed since it was last drawn or not.
+		 * A loop drawing on demand draws a frame only when the active screen or an active overlay is dirty.
+		 * @param dirty True if the gui must be drawn again, else false.
+		 */
+		virtual void set_dirty(bool dirty = true);
+
 		virtual void init() = 0;
 
 		virtual void draw(Graphics *graphics) = 0;
@@ -40,6 +54,7 @@ namespace ionicengine
 	{
 	private:
 		lambdacommon::Color color;
+		bool dirty = false;
 
 	public:
 		Border(const lambdacommon::Color &color);
@@ -48,6 +63,14 @@ namespace ionicengine
 
 		void set_color(const lambdacommon::Color &color);
 
+		/*!
+		 * Checks whether the border changed since the component owning it was last drawn or not.
+		 * @return True if the border must be drawn again, else false.
+		 */
+		bool is_dirty() const;
+
+		void set_dirty(bool dirty);
+
 		virtual void draw(int x, int y, uint32_t width, uint32_t height, Graphics *graphics);
 	};
 
@@ -73,6 +96,14 @@ namespace ionicengine
 
 		virtual ~GuiComponent() override;
 
+		/*!
+		 * Checks whether the component or its border changed since it was last drawn or not.
+		 * @return True if the component must be drawn again, else false.
+		 */
+		bool is_dirty() const override;
+
+		void set_dirty(bool dirty = true) override;
+
 		const lambdacommon::Color &get_color() const;
 
 		void set_color(const lambdacommon::Color &color);
@@ -175,6 +206,12 @@ namespace ionicengine
 				click_color = lambdacommon::color::from_hex(0x6CBADFFF);
 		Font *font;
 		std::function<void(Window &window)> _on_activate_listener = [](Window &window) {};
+		// The layout of the trimmed text, rebuilt only when the text, the font or the size changes.
+		std::shared_ptr<const TextLayout> _layout;
+		const Font *_layout_font = nullptr;
+		uint32_t _layout_width = 0, _layout_height = 0;
+
+		void update_layout();
 
 	public:
 		GuiButton(int x, int y, uint32_t width, uint32_t height, const std::string &text);
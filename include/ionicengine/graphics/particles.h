@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_PARTICLES_H
+#define IONICENGINE_PARTICLES_H
+
+#include "graphics.h"
+#include <vector>
+
+#define IONIC_PARTICLES_PER_TASK 16384    // Particles updated by one worker task, a multiple of the SIMD width.
+
+namespace ionicengine
+{
+	/*!
+	 * Initial state of an emitted particle.
+	 */
+	struct Particle
+	{
+		float x, y;
+		float velocity_x, velocity_y;
+		/*!
+		 * Lifetime in seconds.
+		 */
+		float lifetime;
+	};
+
+	/*!
+	 * Set of particles sharing a texture, an acceleration and color and size ramps over their lifetime.
+	 * The particles are stored as one array per component, updated with SIMD kernels and drawn with one instanced draw.
+	 */
+	class IONICENGINE_API ParticleSystem
+	{
+	private:
+		size_t _max_particles;
+		size_t _count = 0;
+		std::vector<float> _x, _y, _velocity_x, _velocity_y, _life, _inverse_lifetime;
+		// Computed by the update from the age of the particles.
+		std::vector<float> _size, _red, _green, _blue, _alpha;
+		float _acceleration_x = 0.f, _acceleration_y = 0.f;
+		float _start_size = 1.f, _end_size = 1.f;
+		lambdacommon::Color _start_color = lambdacommon::Color::COLOR_WHITE, _end_color = lambdacommon::Color::COLOR_WHITE;
+		bool _parallel = true;
+		std::vector<SpriteInstance> _instances;
+
+		void update_range(size_t begin, size_t end, float delta);
+
+		void remove_dead();
+
+	public:
+		/*!
+		 * Creates an empty particle system, the storage of every particle is allocated once.
+		 * @param max_particles The maximum number of living particles.
+		 */
+		explicit ParticleSystem(size_t max_particles);
+
+		size_t get_max_particles() const;
+
+		/*!
+		 * Gets the number of living particles.
+		 * @return The number of particles.
+		 */
+		size_t get_count() const;
+
+		/*!
+		 * Sets the acceleration applied to every particle, in pixels per second squared.
+		 * @param x The horizontal acceleration.
+		 * @param y The vertical acceleration.
+		 */
+		void set_acceleration(float x, float y);
+
+		/*!
+		 * Sets the colors of the particles, interpolated over their lifetime.
+		 * @param start The color at birth.
+		 * @param end The color at death.
+		 */
+		void set_color(const lambdacommon::Color &start, const lambdacommon::Color &end);
+
+		/*!
+		 * Sets the sizes in pixels of the particles, interpolated over their lifetime.
+		 * @param start The size at birth.
+		 * @param end The size at death.
+		 */
+		void set_size(float start, float end);
+
+		bool is_parallel() const;
+
+		/*!
+		 * Sets whether large updates are split across the worker pool or not.
+		 * @param parallel True to update on the worker pool, else false.
+		 */
+		void set_parallel(bool parallel);
+
+		/*!
+		 * Emits a particle.
+		 * @param particle The initial state of the particle.
+		 * @return True if the particle was emitted, false if the system is full.
+		 */
+		bool emit(const Particle &particle);
+
+		/*!
+		 * Moves the particles, ages them and removes the dead ones.
+		 * @param delta The elapsed time in seconds.
+		 */
+		void update(float delta);
+
+		/*!
+		 * Draws every living particle centered on its position.
+		 * @param graphics The graphics to draw with.
+		 * @param texture The texture of the particles.
+		 */
+		void draw(Graphics *graphics, const Texture &texture);
+
+		/*!
+		 * Removes every particle.
+		 */
+		void clear();
+
+		/*!
+		 * Gets the instruction set the update kernels were compiled for.
+		 * @return "AVX2", "SSE2" or "scalar".
+		 */
+		static const char *get_instruction_set();
+	};
+}
+
+#endif //IONICENGINE_PARTICLES_H
@@ -0,0 +1,72 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_RENDERTARGET_H
+#define IONICENGINE_RENDERTARGET_H
+
+#include "textures.h"
+
+namespace ionicengine
+{
+	/*!
+	 * Framebuffer drawing into a texture instead of the window.
+	 * Like a texture it is a handle: copies share the same OpenGL objects and {@code destroy} deletes them.
+	 */
+	class IONICENGINE_API RenderTarget
+	{
+	private:
+		uint32_t _framebuffer = 0, _texture = 0;
+		uint32_t _width = 0, _height = 0;
+
+	public:
+		uint32_t get_width() const;
+
+		uint32_t get_height() const;
+
+		/*!
+		 * Checks whether the OpenGL objects of the target exist or not.
+		 * @return True if the target can be drawn into, else false.
+		 */
+		bool is_created() const;
+
+		/*!
+		 * Creates the target, or resizes its texture. The content of the texture is undefined afterwards.
+		 * @param width The width in pixels.
+		 * @param height The height in pixels.
+		 */
+		void resize(uint32_t width, uint32_t height);
+
+		/*!
+		 * Redirects the next draws into the target. The viewport is left unchanged.
+		 */
+		void bind() const;
+
+		/*!
+		 * Redirects the next draws into the window.
+		 */
+		static void unbind();
+
+		/*!
+		 * Gets the texture holding what was drawn into the target, with premultiplied colors.
+		 * Its first row is the bottom of the target, a flipped region draws it upright.
+		 * @return The texture.
+		 */
+		Texture get_texture() const;
+
+		/*!
+		 * Gets the region drawing the texture of a target upright.
+		 * @return The flipped region.
+		 */
+		static TextureRegion get_upright_region();
+
+		void destroy();
+	};
+}
+
+#endif //IONICENGINE_RENDERTARGET_H
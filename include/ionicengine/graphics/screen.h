@@ -11,16 +11,45 @@
 #define IONICENGINE_SCREEN_H
 
 #include "gui.h"
+#include "drawlist.h"
+#include "rendertarget.h"
 #include "../window/window.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <thread>
 
+#define IONIC_LOOP_SPIN_TIME 0.002    // Seconds spun before a paced frame instead of sleeping, sleeps are less precise.
+#define IONIC_SCREEN_MAX_DAMAGE_RECTS 4    // Damage rectangles above which a screen redraws their bounding box.
+
 namespace ionicengine
 {
+	/*!
+	 * An area of a screen to draw again, in the coordinates of the graphics.
+	 */
+	struct DamageRect
+	{
+		int min_x, min_y, max_x, max_y;
+	};
+
 	class IONICENGINE_API Screen : public Gui
 	{
 	protected:
 		std::vector<GuiComponent *> components;
 		int32_t focus = -1;
+		bool cached = false;
+		RenderTarget cache;
+		std::vector<DamageRect> damage;
+		/*!
+		 * The area drawn again into the cache, the components outside of it are not drawn.
+		 */
+		std::optional<DamageRect> redraw_area;
+
+		/*!
+		 * Adds the bounds of the dirty components to the damage.
+		 */
+		void collect_damage();
 
 	public:
 		void draw(Graphics *graphics) override;
@@ -29,6 +58,56 @@ namespace ionicengine
 
 		void refresh(uint32_t width, uint32_t height);
 
+		/*!
+		 * Checks whether the screen or one of its components changed since it was last drawn or not.
+		 * @return True if the screen must be drawn again, else false.
+		 */
+		bool is_dirty() const override;
+
+		/*!
+		 * Sets whether the whole screen must be drawn again or not, false also clears the damage.
+		 * @param dirty True if the screen must be drawn again, else false.
+		 */
+		void set_dirty(bool dirty = true) override;
+
+		/*!
+		 * Marks an area of the screen to draw again, for changes the components don't track.
+		 * A cached screen only draws the damaged areas again when the rest of the screen didn't change.
+		 * Overlapping areas are merged, too many areas are merged into their bounding box.
+		 * @param x The left of the area.
+		 * @param y The top of the area.
+		 * @param width The width of the area.
+		 * @param height The height of the area.
+		 */
+		void add_damage(int x, int y, uint32_t width, uint32_t height);
+
+		const std::vector<DamageRect> &get_damage() const;
+
+		bool is_cached() const;
+
+		/*!
+		 * Sets whether the screen is drawn into a texture or not.
+		 * A cached screen is drawn again only when it is dirty or the framebuffer is resized,
+		 * the other frames draw its texture with one quad. When only components changed or areas were damaged,
+		 * the bounding box of the damage is drawn again into the texture in one pass with a scissor,
+		 * skipping the components outside of it.
+		 * @param cached True to cache the screen, else false.
+		 */
+		void set_cached(bool cached);
+
+		/*!
+		 * Draws the screen, through its cache if it is cached.
+		 * @param graphics The graphics to draw with.
+		 * @param framebuffer_size The size in pixels of the framebuffer, which is also the size of the cache.
+		 */
+		void draw_cached(Graphics *graphics, const Dimension2D_u32 &framebuffer_size);
+
+		/*!
+		 * Deletes the texture of the cache, it is created again by the next cached draw.
+		 * The OpenGL context must be current.
+		 */
+		void release_cache();
+
 		GuiComponent *get_focused_component() const;
 
 		void change_focused_component(bool forward = true);
@@ -54,6 +133,8 @@ namespace ionicengine
 	private:
 		Font _font;
 		int _fps{0};
+		bool _show_render_stats = false;
+		RenderStats _render_stats;
 
 	public:
 		explicit OverlayFPS(const Font &font);
@@ -65,6 +146,65 @@ namespace ionicengine
 		void update() override;
 
 		void updateFPS(int fps);
+
+		bool is_showing_render_stats() const;
+
+		/*!
+		 * Sets whether the rendering statistics of the last frame are shown below the FPS or not.
+		 * @param show True to show the statistics, else false.
+		 */
+		void set_show_render_stats(bool show);
+
+		void update_render_stats(const RenderStats &stats);
+	};
+
+	/*!
+	 * Overlay showing the scopes of the newest profiled frame with their GPU times, and a graph of the past frame times.
+	 * The profiler must be enabled, see {@code profiler::set_enabled}.
+	 */
+	class IONICENGINE_API OverlayProfiler : public Overlay
+	{
+	private:
+		Font _font;
+
+	public:
+		explicit OverlayProfiler(const Font &font);
+
+		void init() override;
+
+		void draw(Graphics *graphics) override;
+
+		void update() override;
+	};
+
+	/*!
+	 * How often the loop of a ScreenManager draws frames.
+	 */
+	struct LoopOptions
+	{
+		/*!
+		 * The maximum number of frames drawn per second, 0 for no limit.
+		 */
+		uint32_t target_fps = 0;
+		/*!
+		 * The swap interval set when the loop starts: 0 disables the vertical synchronization, 1 enables it.
+		 * Unset keeps the one of the driver.
+		 */
+		std::optional<int> swap_interval;
+		/*!
+		 * The maximum number of frames drawn per second while the window is not focused, 0 for no limit.
+		 */
+		uint32_t unfocused_fps = 30;
+		/*!
+		 * Whether no frame is drawn while the window is iconified or not, the updates still run.
+		 */
+		bool pause_when_iconified = true;
+		/*!
+		 * Whether a frame is drawn only when needed or not: when the active screen or an active overlay is dirty,
+		 * after an input or a resize, or when {@code ScreenManager::request_redraw} is called.
+		 * The loop sleeps until then instead of drawing the same frame again.
+		 */
+		bool on_demand = false;
 	};
 
 	using namespace std::rel_ops;
@@ -73,10 +213,10 @@ namespace ionicengine
 	{
 	private:
 		uint32_t _id;
-		std::map<lambdacommon::ResourceName, Screen *> _screens;
-		std::map<lambdacommon::ResourceName, Overlay *> _overlays;
-		lambdacommon::ResourceName _active_screen = IONICENGINE_NULL_RESOURCE;
-		std::vector<lambdacommon::ResourceName> _active_overlays;
+		ResourceStorage<Screen *> _screens;
+		ResourceStorage<Overlay *> _overlays;
+		ResourceHandle _active_screen;
+		std::vector<ResourceHandle> _active_overlays;
 
 		std::optional<Window> _window;
 		Dimension2D_u32 old_framebuffer_size{0, 0};
@@ -85,6 +225,78 @@ namespace ionicengine
 		int fps{0}, updates{0};
 		float delta_time{0.f};
 
+		LoopOptions _loop_options;
+		bool _redraw_requested = true;
+		// The time at which the next frame may be drawn with a frame limit.
+		double _next_frame_time = 0.0;
+
+		bool _render_thread = false;
+		// Frames recorded by the main thread and drawn by the render thread, one list each.
+		DrawList _draw_lists[2];
+		size_t _record_list = 0;
+		bool _frame_ready = false, _stop_rendering = false;
+		std::mutex _frame_mutex;
+		std::condition_variable _frame_condition;
+		std::atomic<int> _rendered_frames{0};
+		// Copied from the graphics after each frame, which may belong to the render thread.
+		mutable std::mutex _stats_mutex;
+		RenderStats _frame_stats, _total_stats;
+		std::mutex _render_tasks_mutex;
+		std::vector<std::function<void()>> _render_tasks;
+
+		/*!
+		 * Draws the active screen then the active overlays, through their caches without a render thread.
+		 * @param graphics The graphics to draw with.
+		 */
+		void draw_frame(Graphics *graphics);
+
+		void release_caches();
+
+		/*!
+		 * Ends the statistics of the frame drawn by the specified graphics and makes them readable from any thread.
+		 * @param graphics The graphics which drew the frame, flushed.
+		 */
+		void publish_render_stats(Graphics *graphics);
+
+		void run_render_tasks();
+
+		/*!
+		 * Refreshes the active screen and overlays if the size of the window changed.
+		 * @param graphics The graphics the screens draw with.
+		 */
+		void check_framebuffer_size(Graphics *graphics);
+
+		void start_threaded_loop();
+
+		/*!
+		 * Gets the minimum time between two frames with the current state of the window.
+		 * @return The time in seconds, 0 if the frames are not limited.
+		 */
+		double get_frame_interval() const;
+
+		/*!
+		 * Checks whether the loop must draw a frame now or not, the frame limit aside.
+		 * @return True if a frame is needed, else false.
+		 */
+		bool needs_frame() const;
+
+		/*!
+		 * Records that a frame was drawn: clears the dirty flags and schedules the next frame.
+		 * @param now The current time.
+		 */
+		void on_frame_drawn(double now);
+
+		/*!
+		 * Processes the events until the specified time, sleeping then spinning the last moments for a precise wake up.
+		 * @param time The time to wait until.
+		 */
+		void wait_until(double time);
+
+		/*!
+		 * Body of the render thread: draws the recorded frames and swaps the buffers until the loop stops.
+		 */
+		void run_render_thread();
+
 	public:
 		ScreenManager();
 
@@ -96,12 +308,16 @@ namespace ionicengine
 
 		Screen *get_screen(const lambdacommon::ResourceName &name) const;
 
+		Screen *get_screen(ResourceHandle screen) const;
+
 		void register_overlay(const lambdacommon::ResourceName &name, Overlay *overlay);
 
 		bool has_overlay(const lambdacommon::ResourceName &name) const;
 
 		Overlay *get_overlay(const lambdacommon::ResourceName &name) const;
 
+		Overlay *get_overlay(ResourceHandle overlay) const;
+
 		Screen *get_active_screen() const;
 
 		void set_active_screen(const lambdacommon::ResourceName &name);
@@ -122,6 +338,18 @@ namespace ionicengine
 
 		int get_updates() const;
 
+		/*!
+		 * Gets the rendering statistics of the last drawn frame, safe to call with a render thread.
+		 * @return The statistics of the last frame.
+		 */
+		RenderStats get_frame_stats() const;
+
+		/*!
+		 * Gets the rendering statistics summed over every frame drawn since the loop started.
+		 * @return The running totals.
+		 */
+		RenderStats get_total_stats() const;
+
 		void set_delta_time(float delta_time);
 
 		float get_delta_time() const;
@@ -134,6 +362,38 @@ namespace ionicengine
 
 		bool on_gamepad_button_input(InputAction action, uint8_t button);
 
+		const LoopOptions &get_loop_options() const;
+
+		/*!
+		 * Sets how often the loop draws frames, can be changed while the loop runs except the swap interval.
+		 * @param options The loop options.
+		 */
+		void set_loop_options(const LoopOptions &options);
+
+		/*!
+		 * Requests a frame to be drawn, needed only when drawing on demand.
+		 */
+		void request_redraw();
+
+		bool has_render_thread() const;
+
+		/*!
+		 * Sets whether the loop draws on a dedicated render thread or not, must be called before {@code start_loop}.
+		 *
+		 * With a render thread, the render thread owns the OpenGL context: the main thread polls the events,
+		 * updates, and records the draws of the screens into a draw list which the render thread replays.
+		 * A blocking buffer swap then no longer delays the input and the updates.
+		 * OpenGL must not be used from the screens, textures are created and deleted through {@code run_on_render_thread}.
+		 * @param render_thread True to draw on a render thread, else false.
+		 */
+		void set_render_thread(bool render_thread);
+
+		/*!
+		 * Runs a task on the thread owning the OpenGL context before the next frame is drawn.
+		 * @param task The task to run.
+		 */
+		void run_on_render_thread(const std::function<void()> &task);
+
 		void render();
 
 		void update();
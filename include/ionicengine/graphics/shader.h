@@ -11,22 +11,37 @@
 #define IONICENGINE_SHADER_H
 
 #include "../ionicengine.h"
+#include "../resource.h"
 #include <lambdacommon/graphics/color.h>
 #include <glm/glm.hpp>
+#include <map>
+#include <memory>
 #include <optional>
+#include <string_view>
 
 namespace ionicengine
 {
 	using namespace std::rel_ops;
 
+	/*!
+	 * Maps the active uniforms names of a shader program to their locations.
+	 * The comparator is transparent so lookups don't allocate.
+	 */
+	typedef std::map<std::string, int32_t, std::less<>> UniformLocations;
+
 	class IONICENGINE_API Shader
 	{
 	private:
 		uint32_t _id;
+		std::shared_ptr<const UniformLocations> _uniforms;
 
 	public:
 		Shader();
 
+		/*!
+		 * Creates a shader from a linked program, the active uniforms are introspected once here.
+		 * @param id The OpenGL program ID.
+		 */
 		Shader(uint32_t id);
 
 		Shader(const Shader &shader);
@@ -35,30 +50,64 @@ namespace ionicengine
 
 		uint32_t get_id() const;
 
+		/*!
+		 * Gets the cached location of the specified uniform.
+		 * Array uniforms are available by their base name and by each "name[index]".
+		 * @param name The name of the uniform.
+		 * @return The location of the uniform or -1 if the uniform is not active.
+		 */
+		int32_t get_uniform_location(std::string_view name) const;
+
+		/*!
+		 * Gets the cached locations of every active uniform.
+		 * @return The uniforms locations.
+		 */
+		const UniformLocations &get_uniform_locations() const;
+
 		Shader &use();
 
 		void set_float(const std::string &name, float value, bool use_shader = false);
 
+		void set_float(int32_t location, float value, bool use_shader = false);
+
 		void set_integer(const std::string &name, int value, bool use_shader = false);
 
+		void set_integer(int32_t location, int value, bool use_shader = false);
+
 		void set_vector_2f(const std::string &name, float x, float y, bool use_shader = false);
 
+		void set_vector_2f(int32_t location, float x, float y, bool use_shader = false);
+
 		void set_vector_2f(const std::string &name, const glm::vec2 &value, bool use_shader = false);
 
+		void set_vector_2f(int32_t location, const glm::vec2 &value, bool use_shader = false);
+
 		void setVector3f(const std::string &name, float x, float y, float z, bool use_shader = false);
 
+		void setVector3f(int32_t location, float x, float y, float z, bool use_shader = false);
+
 		void setVector3f(const std::string &name, const glm::vec3 &value, bool use_shader = false);
 
+		void setVector3f(int32_t location, const glm::vec3 &value, bool use_shader = false);
+
 		void set_vector_4f(const std::string &name, float x, float y, float z, float w, bool use_shader = false);
 
+		void set_vector_4f(int32_t location, float x, float y, float z, float w, bool use_shader = false);
+
 		void set_vector_4f(const std::string &name, const glm::vec4 &value, bool use_shader = false);
 
+		void set_vector_4f(int32_t location, const glm::vec4 &value, bool use_shader = false);
+
 		void set_color(const lambdacommon::Color &color, bool use_shader = false);
 
 		void set_color(const std::string &name, const lambdacommon::Color &color, bool use_shader = false);
 
+		void set_color(int32_t location, const lambdacommon::Color &color, bool use_shader = false);
+
 		void set_matrix_4f(const std::string &name, const glm::mat4 &matrix, bool use_shader = false);
 
+		void set_matrix_4f(int32_t location, const glm::mat4 &matrix, bool use_shader = false);
+
 		explicit operator bool() const;
 
 		Shader &operator=(const Shader &other);
@@ -76,7 +125,11 @@ namespace ionicengine
 
 		extern bool IONICENGINE_API hasShader(const lambdacommon::ResourceName &shader_name);
 
+		extern bool IONICENGINE_API hasShader(ResourceHandle shader);
+
 		extern const Shader &IONICENGINE_API getShader(const lambdacommon::ResourceName &shader_name);
+
+		extern const Shader &IONICENGINE_API getShader(ResourceHandle shader);
 	}
 }
 
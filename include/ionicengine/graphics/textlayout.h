@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_TEXTLAYOUT_H
+#define IONICENGINE_TEXTLAYOUT_H
+
+#include "font.h"
+#include <memory>
+#include <vector>
+
+// Number of layouts kept by the layout cache.
+#define IONIC_TEXT_LAYOUT_CACHE_SIZE 512
+
+namespace ionicengine
+{
+	/*!
+	 * A codepoint placed by a text layout.
+	 */
+	struct LayoutGlyph
+	{
+		char32_t codepoint;
+		/*! Position of the pen relative to the top-left corner of the layout, at the size of the font. */
+		float x, y;
+	};
+
+	/*!
+	 * A line of a text layout.
+	 */
+	struct LayoutLine
+	{
+		/*! Index of the first glyph of the line. */
+		size_t first_glyph;
+		size_t glyph_count;
+		/*! Width of the line, at the size of the font. */
+		float width;
+	};
+
+	/*!
+	 * The glyph positions, the line breaks and the bounds of a text, computed once for a font and a wrap width.
+	 * Explicit line breaks are honoured and lines longer than the wrap width are broken after the last space,
+	 * or before the overflowing codepoint if the word is longer than a line.
+	 */
+	class IONICENGINE_API TextLayout : public std::enable_shared_from_this<TextLayout>
+	{
+	private:
+		Font _font;
+		uint32_t _wrap_width;
+		std::vector<LayoutGlyph> _glyphs;
+		std::vector<LayoutLine> _lines;
+		float _width = 0.f;
+
+	public:
+		/*!
+		 * Lays out a text.
+		 * @param font The font of the text.
+		 * @param text The UTF-8 text.
+		 * @param wrap_width The maximum width of a line in pixels, 0 to only break lines on line feeds.
+		 */
+		TextLayout(const Font &font, const std::string &text, uint32_t wrap_width = 0);
+
+		const Font &get_font() const;
+
+		uint32_t get_wrap_width() const;
+
+		const std::vector<LayoutGlyph> &get_glyphs() const;
+
+		const std::vector<LayoutLine> &get_lines() const;
+
+		/*!
+		 * Gets the width of the longest line in pixels.
+		 * @return The width of the layout.
+		 */
+		uint32_t get_width() const;
+
+		/*!
+		 * Gets the height of the lines in pixels.
+		 * @return The height of the layout.
+		 */
+		uint32_t get_height() const;
+	};
+
+	namespace text_layout
+	{
+		/*!
+		 * Gets the layout of a text from the layout cache, laying it out if it isn't cached.
+		 * The least recently used layout is dropped once the cache holds IONIC_TEXT_LAYOUT_CACHE_SIZE layouts.
+		 * @param font The font of the text.
+		 * @param text The UTF-8 text.
+		 * @param wrap_width The maximum width of a line in pixels, 0 to only break lines on line feeds.
+		 * @return The layout of the text.
+		 */
+		extern std::shared_ptr<const TextLayout> IONICENGINE_API
+		get(const Font &font, const std::string &text, uint32_t wrap_width = 0);
+
+		/*!
+		 * Gets the number of layouts in the layout cache.
+		 * @return The number of cached layouts.
+		 */
+		extern size_t IONICENGINE_API get_cache_size();
+
+		/*!
+		 * Drops every cached layout, and with them the fonts they keep alive.
+		 */
+		extern void IONICENGINE_API clear_cache();
+	}
+}
+
+#endif //IONICENGINE_TEXTLAYOUT_H
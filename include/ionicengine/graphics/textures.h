@@ -11,8 +11,13 @@
 #define IONICENGINE_TEXTURES_H
 
 #include "../includes.h"
+#include "../resource.h"
+#include <future>
 #include <optional>
 
+#define IONIC_TEXTURE_UPLOAD_BUDGET_MS 2.0    // Time spent uploading textures each frame.
+#define IONIC_TEXTURE_UPLOAD_CHUNK_SIZE 1048576    // Bytes streamed through the pixel buffer per upload step.
+
 namespace ionicengine
 {
 	using namespace std::rel_ops;
@@ -164,6 +169,11 @@ namespace ionicengine
 		explicit operator bool() const;
 	};
 
+	/*!
+	 * Future result of an asynchronous texture load, empty if the image cannot be loaded.
+	 */
+	typedef std::shared_future<std::optional<Texture>> TextureFuture;
+
 	namespace texture
 	{
 		extern std::optional<Texture> IONICENGINE_API
@@ -171,6 +181,38 @@ namespace ionicengine
 			 TextureWrapMode wrap_mode = CLAMP, TextureFilterMode filter_mode = NEAREST_MIPMAP_LINEAR,
 			 bool use_mipmap = true);
 
+		/*!
+		 * Loads a texture in the background: the image is decoded on the worker pool,
+		 * then uploaded on the thread owning the OpenGL context by {@code process_uploads}.
+		 * Must be called from that thread, see {@code ScreenManager::run_on_render_thread}.
+		 * @param name The resource name of the texture.
+		 * @param extension The extension of the image file.
+		 * @param wrap_mode The wrap mode of the texture.
+		 * @param filter_mode The filter mode of the texture.
+		 * @param use_mipmap True to generate the mipmaps once uploaded, else false.
+		 * @return The future texture, ready once the upload completed.
+		 */
+		extern TextureFuture IONICENGINE_API
+		load_async(const lambdacommon::ResourceName &name, const std::string &extension = "png",
+				   TextureWrapMode wrap_mode = CLAMP, TextureFilterMode filter_mode = NEAREST_MIPMAP_LINEAR,
+				   bool use_mipmap = true);
+
+		/*!
+		 * Streams the decoded asynchronous loads to the GPU through a pixel buffer object.
+		 * Large images are uploaded in chunks over several calls so that a frame never stalls on them, the mipmaps of a
+		 * texture are generated as a step of their own at the start of the call after its last chunk.
+		 * Called every frame by the ScreenManager loop.
+		 * @param budget_ms The time in milliseconds allowed for the uploads, at least one chunk is uploaded.
+		 * @return True if uploads are still pending, else false.
+		 */
+		extern bool IONICENGINE_API process_uploads(double budget_ms = IONIC_TEXTURE_UPLOAD_BUDGET_MS);
+
+		/*!
+		 * Gets the number of asynchronous loads not completed yet.
+		 * @return The number of pending loads.
+		 */
+		extern size_t IONICENGINE_API get_pending_loads();
+
 		extern Texture IONICENGINE_API
 		create(const lambdacommon::ResourceName &name, unsigned char image[], uint32_t width, uint32_t height,
 			   uint32_t channels = 4, TextureWrapMode wrap_mode = CLAMP,
@@ -178,14 +220,27 @@ namespace ionicengine
 
 		extern Texture IONICENGINE_API get_texture(const lambdacommon::ResourceName &name);
 
+		extern Texture IONICENGINE_API get_texture(ResourceHandle handle);
+
+		/*!
+		 * Gets the texture registered with the specified handle with a single lookup.
+		 * @param handle The handle of the texture.
+		 * @return A pointer to the texture or null if there is no texture registered with this handle.
+		 */
+		extern const Texture *IONICENGINE_API find_texture(ResourceHandle handle);
+
 		extern bool IONICENGINE_API has_texture(const lambdacommon::ResourceName &name);
 
+		extern bool IONICENGINE_API has_texture(ResourceHandle handle);
+
 		extern TextureRegion
 		new_texture_region(uint32_t textureWidth, uint32_t textureHeight, uint32_t x, uint32_t y, uint32_t width,
 						   uint32_t height);
 
 		extern void IONICENGINE_API delete_texture(const lambdacommon::ResourceName &name);
 
+		extern void IONICENGINE_API delete_texture(ResourceHandle handle);
+
 		extern void IONICENGINE_API bind(uint32_t id);
 
 		extern void IONICENGINE_API unbind();
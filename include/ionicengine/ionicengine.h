@@ -27,17 +27,27 @@
 
 #define IONICENGINE_NULL_RESOURCE lambdacommon::ResourceName("ionicengine", "null")
 #define IONICENGINE_GRAPHICS_GL3 lambdacommon::ResourceName("ionicengine", "graphics/gl3")
+#define IONICENGINE_GRAPHICS_GL3_SORTED lambdacommon::ResourceName("ionicengine", "graphics/gl3_sorted")
 #define IONICENGINE_OVERLAYS_FPS lambdacommon::ResourceName("ionicengine", "overlays/fps")
+#define IONICENGINE_OVERLAYS_PROFILER lambdacommon::ResourceName("ionicengine", "overlays/profiler")
 #define IONICENGINE_SHADERS_2DBASIC lambdacommon::ResourceName("ionicengine", "shaders/2dbasic")
 #define IONICENGINE_SHADERS_IMAGE lambdacommon::ResourceName("ionicengine", "shaders/image")
+#define IONICENGINE_SHADERS_SPRITE lambdacommon::ResourceName("ionicengine", "shaders/sprite")
+#define IONICENGINE_SHADERS_PRIMITIVE lambdacommon::ResourceName("ionicengine", "shaders/primitive")
+#define IONICENGINE_SHADERS_SPRITE_INSTANCED lambdacommon::ResourceName("ionicengine", "shaders/sprite_instanced")
 #define IONICENGINE_SHADERS_TEXT lambdacommon::ResourceName("ionicengine", "shaders/text")
+#define IONICENGINE_SHADERS_TEXT_SDF lambdacommon::ResourceName("ionicengine", "shaders/text_sdf")
 
 namespace ionicengine
 {
 	const lambdacommon::ResourceName GRAPHICS_GL3 = IONICENGINE_GRAPHICS_GL3;
 
+	const lambdacommon::ResourceName GRAPHICS_GL3_SORTED = IONICENGINE_GRAPHICS_GL3_SORTED;
+
 	const lambdacommon::ResourceName SHADER_TEXT = IONICENGINE_SHADERS_TEXT;
 
+	const lambdacommon::ResourceName SHADER_TEXT_SDF = IONICENGINE_SHADERS_TEXT_SDF;
+
 	using lambdacommon::Dimension2D_u32;
 
 	struct IonicOptions
@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_MAPPEDFILE_H
+#define IONICENGINE_MAPPEDFILE_H
+
+#include "includes.h"
+
+namespace ionicengine
+{
+	/*!
+	 * Read-only memory mapping of a whole file, the pages are loaded by the system when first read.
+	 */
+	class IONICENGINE_API MappedFile
+	{
+	private:
+		const unsigned char *_data = nullptr;
+		size_t _size = 0;
+#ifdef LAMBDA_WINDOWS
+		void *_file = nullptr;
+		void *_mapping = nullptr;
+#else
+		int _file = -1;
+#endif
+
+	public:
+		MappedFile();
+
+		/*!
+		 * Maps the file at the specified path, check the result with {@code operator bool}.
+		 * @param path The path of the file.
+		 */
+		explicit MappedFile(const std::string &path);
+
+		MappedFile(const MappedFile &other) = delete;
+
+		MappedFile(MappedFile &&other) noexcept;
+
+		~MappedFile();
+
+		/*!
+		 * Maps the file at the specified path, the previously mapped file is unmapped.
+		 * @param path The path of the file.
+		 * @return True if the file is mapped, else false.
+		 */
+		bool open(const std::string &path);
+
+		void close();
+
+		const unsigned char *get_data() const;
+
+		size_t get_size() const;
+
+		explicit operator bool() const;
+
+		MappedFile &operator=(const MappedFile &other) = delete;
+
+		MappedFile &operator=(MappedFile &&other) noexcept;
+	};
+}
+
+#endif //IONICENGINE_MAPPEDFILE_H
@@ -0,0 +1,131 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_PROFILER_H
+#define IONICENGINE_PROFILER_H
+
+#include "includes.h"
+#include <deque>
+#include <vector>
+
+#define IONIC_PROFILER_HISTORY 120    // Number of past frames kept by the profiler.
+#define IONIC_PROFILER_QUERY_LATENCY 4    // Frames waited before reading the GPU timer queries back.
+
+#define IONIC_PROFILE_CONCAT_(a, b) a##b
+#define IONIC_PROFILE_CONCAT(a, b) IONIC_PROFILE_CONCAT_(a, b)
+/*!
+ * Measures the CPU time of the rest of the enclosing block.
+ */
+#define IONIC_PROFILE_SCOPE(name) ionicengine::profiler::ProfileScope IONIC_PROFILE_CONCAT(ionic_profile_scope_, __LINE__){name}
+/*!
+ * Measures the CPU and GPU time of the rest of the enclosing block, the OpenGL context must be current.
+ */
+#define IONIC_PROFILE_GPU_SCOPE(name) ionicengine::profiler::ProfileScope IONIC_PROFILE_CONCAT(ionic_profile_scope_, __LINE__){name, true}
+
+namespace ionicengine
+{
+	/*!
+	 * The time spent in a scope during a frame, every call of a scope in the same parent is merged.
+	 */
+	struct ProfileSample
+	{
+		const char *name;
+		/*!
+		 * The index of the enclosing sample in the frame, -1 for a root sample.
+		 */
+		int32_t parent;
+		uint32_t depth;
+		uint32_t calls;
+		double cpu_ms;
+		/*!
+		 * The GPU time, negative if the scope is not measured on the GPU or the results were not ready in time.
+		 */
+		double gpu_ms;
+	};
+
+	struct ProfileFrame
+	{
+		uint64_t index;
+		/*!
+		 * The time from the start of this frame to the start of the next one.
+		 */
+		double frame_ms;
+		/*!
+		 * The samples in call order, a sample comes after its parent.
+		 */
+		std::vector<ProfileSample> samples;
+		/*!
+		 * Whether the GPU times were read back or not.
+		 */
+		bool gpu_resolved;
+	};
+
+	/*!
+	 * Frame profiler of nestable scopes.
+	 * Only the thread which enabled the profiler is measured, the scopes of the other threads are ignored.
+	 * GPU scopes put timestamp queries around their commands, read back {@code IONIC_PROFILER_QUERY_LATENCY} frames
+	 * later so the CPU never waits for the GPU. Results still not available by then are dropped.
+	 */
+	namespace profiler
+	{
+		extern bool IONICENGINE_API is_enabled();
+
+		/*!
+		 * Enables or disables the profiler, disabling it clears the history.
+		 * The OpenGL context must be current when disabling it after GPU scopes were measured.
+		 * @param enabled True to enable the profiler on the calling thread, else false.
+		 */
+		extern void IONICENGINE_API set_enabled(bool enabled);
+
+		/*!
+		 * Ends the current frame and starts a new one, called by the loop of the ScreenManager.
+		 */
+		extern void IONICENGINE_API new_frame();
+
+		/*!
+		 * Opens a scope, scopes must be closed in the reverse order they were opened.
+		 * @param name The name of the scope, it must outlive the profiler history.
+		 * @param gpu True to measure the GPU time too, else false.
+		 * @return True if the scope is measured, else false.
+		 */
+		extern bool IONICENGINE_API begin_scope(const char *name, bool gpu = false);
+
+		extern void IONICENGINE_API end_scope();
+
+		/*!
+		 * Gets the past frames, the newest last. The newest frames wait for their GPU times.
+		 * @return The past frames.
+		 */
+		extern const std::deque<ProfileFrame> &IONICENGINE_API get_history();
+
+		/*!
+		 * Gets the newest frame with its GPU times read back.
+		 * @return The frame, or null if there is none yet.
+		 */
+		extern const ProfileFrame *IONICENGINE_API get_resolved_frame();
+
+		/*!
+		 * Scope closed at the end of the enclosing block, see {@code IONIC_PROFILE_SCOPE}.
+		 */
+		class IONICENGINE_API ProfileScope
+		{
+		private:
+			bool _active;
+
+		public:
+			explicit ProfileScope(const char *name, bool gpu = false);
+
+			ProfileScope(const ProfileScope &other) = delete;
+
+			~ProfileScope();
+		};
+	}
+}
+
+#endif //IONICENGINE_PROFILER_H
@@ -0,0 +1,188 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_RESOURCE_H
+#define IONICENGINE_RESOURCE_H
+
+#include "includes.h"
+#include <deque>
+#include <optional>
+#include <stdexcept>
+
+namespace ionicengine
+{
+	/*!
+	 * Dense integer identifier of an interned ResourceName.
+	 * Every resource kind shares the same handle space, the handle of a name never changes.
+	 */
+	class IONICENGINE_API ResourceHandle
+	{
+	private:
+		uint32_t _index;
+
+	public:
+		static const uint32_t INVALID = 0xFFFFFFFFu;
+
+		constexpr ResourceHandle() : _index(INVALID)
+		{}
+
+		explicit constexpr ResourceHandle(uint32_t index) : _index(index)
+		{}
+
+		constexpr uint32_t get_index() const
+		{
+			return _index;
+		}
+
+		constexpr explicit operator bool() const
+		{
+			return _index != INVALID;
+		}
+
+		constexpr bool operator==(const ResourceHandle &other) const
+		{
+			return _index == other._index;
+		}
+
+		constexpr bool operator!=(const ResourceHandle &other) const
+		{
+			return _index != other._index;
+		}
+
+		constexpr bool operator<(const ResourceHandle &other) const
+		{
+			return _index < other._index;
+		}
+	};
+
+	namespace resource
+	{
+		/*!
+		 * Gets the handle of the specified resource name, the name is interned on the first call.
+		 * @param name The resource name.
+		 * @return The handle of the resource name.
+		 */
+		extern ResourceHandle IONICENGINE_API intern(const lambdacommon::ResourceName &name);
+
+		/*!
+		 * Gets the handle of the specified resource name without interning it.
+		 * @param name The resource name.
+		 * @return The handle of the resource name or an invalid handle if the name was never interned.
+		 */
+		extern ResourceHandle IONICENGINE_API find(const lambdacommon::ResourceName &name);
+
+		/*!
+		 * Gets the resource name of the specified handle.
+		 * @param handle The handle.
+		 * @return The resource name.
+		 */
+		extern lambdacommon::ResourceName IONICENGINE_API get_name(ResourceHandle handle);
+
+		/*!
+		 * Gets the number of interned resource names.
+		 * @return The number of interned names.
+		 */
+		extern size_t IONICENGINE_API count();
+	}
+
+	/*!
+	 * Stores resources of one kind indexed by their handle, a lookup is a single array access.
+	 * References to stored resources stay valid when other resources are added.
+	 * @tparam T The type of the resources.
+	 */
+	template<typename T>
+	class ResourceStorage
+	{
+	private:
+		std::deque<std::optional<T>> _slots;
+		size_t _size = 0;
+
+	public:
+		bool has(ResourceHandle handle) const
+		{
+			return handle.get_index() < _slots.size() && _slots[handle.get_index()].has_value();
+		}
+
+		/*!
+		 * Gets the resource of the specified handle.
+		 * @param handle The handle of the resource.
+		 * @return A pointer to the resource or null if there is no resource with this handle.
+		 */
+		T *find(ResourceHandle handle)
+		{
+			if (!has(handle))
+				return nullptr;
+			return &*_slots[handle.get_index()];
+		}
+
+		const T *find(ResourceHandle handle) const
+		{
+			if (!has(handle))
+				return nullptr;
+			return &*_slots[handle.get_index()];
+		}
+
+		const T &at(ResourceHandle handle) const
+		{
+			if (!has(handle))
+				throw std::out_of_range("No resource stored with the handle " + std::to_string(handle.get_index()));
+			return *_slots[handle.get_index()];
+		}
+
+		T &set(ResourceHandle handle, T resource)
+		{
+			if (!handle)
+				throw std::invalid_argument("Cannot store a resource with an invalid handle.");
+			if (handle.get_index() >= _slots.size())
+				_slots.resize(handle.get_index() + 1);
+			if (!_slots[handle.get_index()])
+				_size++;
+			_slots[handle.get_index()] = std::move(resource);
+			return *_slots[handle.get_index()];
+		}
+
+		void erase(ResourceHandle handle)
+		{
+			if (!has(handle))
+				return;
+			_slots[handle.get_index()].reset();
+			_size--;
+		}
+
+		size_t size() const
+		{
+			return _size;
+		}
+
+		bool empty() const
+		{
+			return _size == 0;
+		}
+
+		void clear()
+		{
+			_slots.clear();
+			_size = 0;
+		}
+
+		/*!
+		 * Calls the specified function for every stored resource, in handle order.
+		 * @param function The function taking the handle and a reference to the resource.
+		 */
+		template<typename F>
+		void for_each(F function)
+		{
+			for (size_t i = 0; i < _slots.size(); i++)
+				if (_slots[i])
+					function(ResourceHandle{static_cast<uint32_t>(i)}, *_slots[i]);
+		}
+	};
+}
+
+#endif //IONICENGINE_RESOURCE_H
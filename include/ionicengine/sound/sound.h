@@ -11,6 +11,7 @@
 #define IONICENGINE_SOUND_H
 
 #include "../includes.h"
+#include "../resource.h"
 #include <al.h>
 
 #define IONIC_SOUND_MAX_BUFFERS 500    // How many different sounds we can keep in memory at once.
@@ -35,6 +36,8 @@ namespace ionicengine
 
 		extern int IONICENGINE_API get_sound_index(const lambdacommon::ResourceName &sound);
 
+		extern int IONICENGINE_API get_sound_index(ResourceHandle sound);
+
 		/*!
 		 * Checks whether there is a sound registered with the specified resource name.
 		 * @param sound The name of the sound to check.
@@ -42,6 +45,8 @@ namespace ionicengine
 		 */
 		extern bool IONICENGINE_API has_sound(const lambdacommon::ResourceName &sound);
 
+		extern bool IONICENGINE_API has_sound(ResourceHandle sound);
+
 		/*!
 		 * Plays the specified sound.
 		 * @param sound The sound to play.
@@ -50,6 +55,14 @@ namespace ionicengine
 		 */
 		extern int IONICENGINE_API play(const lambdacommon::ResourceName &sound, bool loop = false);
 
+		/*!
+		 * Plays the specified sound.
+		 * @param sound The handle of the sound to play.
+		 * @param loop True if the sound is looped, else false.
+		 * @return The source index of the sound or -1 if any error happened.
+		 */
+		extern int IONICENGINE_API play(ResourceHandle sound, bool loop = false);
+
 		/*!
 		 * Plays the specified sound.
 		 * @param buffer The buffer index of the sound to play.
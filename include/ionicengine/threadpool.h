@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_THREADPOOL_H
+#define IONICENGINE_THREADPOOL_H
+
+#include "includes.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ionicengine
+{
+	/*!
+	 * Fixed set of worker threads running submitted tasks in submission order.
+	 */
+	class IONICENGINE_API ThreadPool
+	{
+	private:
+		std::vector<std::thread> _workers;
+		std::deque<std::function<void()>> _tasks;
+		mutable std::mutex _mutex;
+		std::condition_variable _condition;
+		bool _stopping = false;
+
+		void enqueue(std::function<void()> task);
+
+		void work();
+
+	public:
+		/*!
+		 * Starts the worker threads.
+		 * @param threads The number of worker threads, 0 picks one less than the number of hardware threads.
+		 */
+		explicit ThreadPool(size_t threads = 0);
+
+		ThreadPool(const ThreadPool &other) = delete;
+
+		~ThreadPool();
+
+		size_t get_thread_count() const;
+
+		/*!
+		 * Gets the number of submitted tasks not started yet.
+		 * @return The number of queued tasks.
+		 */
+		size_t get_queued_tasks() const;
+
+		/*!
+		 * Submits a task to the pool. Once the pool is shut down the task runs on the calling thread.
+		 * @param task The task to run.
+		 * @return The future result of the task.
+		 */
+		template<typename F>
+		std::future<std::invoke_result_t<F>> submit(F &&task)
+		{
+			// std::function must be copyable, the packaged task is shared instead.
+			auto packaged_task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(task));
+			auto future = packaged_task->get_future();
+			enqueue([packaged_task]()
+					{
+						(*packaged_task)();
+					});
+			return future;
+		}
+
+		/*!
+		 * Runs the queued tasks and stops the worker threads.
+		 */
+		void shutdown();
+	};
+
+	/*!
+	 * Gets the engine-wide worker pool used by the asynchronous loaders, it is started on the first call.
+	 * @return The worker pool.
+	 */
+	extern ThreadPool &IONICENGINE_API get_worker_pool();
+
+	/*!
+	 * Runs the tasks queued in the worker pool and stops its threads, if it was started.
+	 */
+	extern void IONICENGINE_API shutdown_worker_pool();
+}
+
+#endif //IONICENGINE_THREADPOOL_H
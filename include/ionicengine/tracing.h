@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#ifndef IONICENGINE_TRACING_H
+#define IONICENGINE_TRACING_H
+
+#include "includes.h"
+#include <string>
+
+#define IONIC_TRACE_DEFAULT_CAPACITY 65536    // Default number of events recorded per thread in a capture.
+
+#define IONIC_TRACE_CONCAT_(a, b) a##b
+#define IONIC_TRACE_CONCAT(a, b) IONIC_TRACE_CONCAT_(a, b)
+/*!
+ * Traces the rest of the enclosing block, on any thread.
+ */
+#define IONIC_TRACE_SCOPE(name) ionicengine::tracing::TraceScope IONIC_TRACE_CONCAT(ionic_trace_scope_, __LINE__){name}
+
+namespace ionicengine
+{
+	/*!
+	 * Timeline of begin and end events of every thread, written as Chrome trace JSON for a trace viewer.
+	 * Nothing is recorded until a capture is started.
+	 * Each thread records into its own buffer without locking, the buffer is allocated on its first event of a
+	 * capture. Events not fitting in the buffer are dropped, a scope is either recorded with its end or not at all.
+	 */
+	namespace tracing
+	{
+		extern bool IONICENGINE_API is_enabled();
+
+		/*!
+		 * Starts a new capture, the events of the previous one are discarded.
+		 * Must not be called while the previous capture is written.
+		 * @param capacity The maximum number of events recorded per thread.
+		 */
+		extern void IONICENGINE_API start(size_t capacity = IONIC_TRACE_DEFAULT_CAPACITY);
+
+		/*!
+		 * Stops recording new scopes, the scopes already open still record their end.
+		 */
+		extern void IONICENGINE_API stop();
+
+		/*!
+		 * Names the calling thread in the captures.
+		 * @param name The name of the thread, it must outlive the captures.
+		 */
+		extern void IONICENGINE_API set_thread_name(const char *name);
+
+		/*!
+		 * Records the beginning of a scope on the calling thread.
+		 * @param name The name of the scope, it must outlive the capture.
+		 * @return True if the scope is recorded and {@code end} must be called, else false.
+		 */
+		extern bool IONICENGINE_API begin(const char *name);
+
+		/*!
+		 * Records the end of the last scope recorded by the calling thread.
+		 */
+		extern void IONICENGINE_API end();
+
+		/*!
+		 * Records an instant event on the calling thread, e.g. the start of a frame.
+		 * @param name The name of the event, it must outlive the capture.
+		 */
+		extern void IONICENGINE_API instant(const char *name);
+
+		/*!
+		 * Gets the number of events dropped in the current capture because a buffer was full.
+		 * @return The number of dropped events.
+		 */
+		extern uint64_t IONICENGINE_API get_dropped_events();
+
+		/*!
+		 * Writes the events of the current capture as Chrome trace JSON, the capture should be stopped first.
+		 * @param path The path of the file to write.
+		 * @return True if the file was written, else false.
+		 */
+		extern bool IONICENGINE_API write(const std::string &path);
+
+		/*!
+		 * Scope recorded until the end of the enclosing block, see {@code IONIC_TRACE_SCOPE}.
+		 */
+		class IONICENGINE_API TraceScope
+		{
+		private:
+			bool _active;
+
+		public:
+			explicit TraceScope(const char *name);
+
+			TraceScope(const TraceScope &other) = delete;
+
+			~TraceScope();
+		};
+	}
+}
+
+#endif //IONICENGINE_TRACING_H
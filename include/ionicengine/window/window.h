@@ -86,6 +86,8 @@ namespace ionicengine
 
 		void iconify() const;
 
+		bool is_iconified() const;
+
 		void maximize() const;
 
 		void restore() const;
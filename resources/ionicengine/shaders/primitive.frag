@@ -0,0 +1,8 @@
+#version 330 core
+in vec4 primitiveColor;
+out vec4 color;
+
+void main()
+{
+    color = primitiveColor;
+}
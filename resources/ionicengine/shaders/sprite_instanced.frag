@@ -0,0 +1,11 @@
+#version 330 core
+in vec2 texCoords;
+in vec4 spriteColor;
+out vec4 color;
+
+uniform sampler2D image;
+
+void main()
+{
+    color = spriteColor * texture(image, texCoords);
+}
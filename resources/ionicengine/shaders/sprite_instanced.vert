@@ -0,0 +1,24 @@
+#version 330 core
+layout (location = 0) in vec3 vertex;
+layout (location = 1) in vec4 instanceBounds;
+layout (location = 2) in float instanceRotation;
+layout (location = 3) in vec4 instanceColor;
+layout (location = 4) in vec4 instanceRegion;
+out vec2 texCoords;
+out vec4 spriteColor;
+
+uniform mat4 projection;
+uniform vec4 color;
+
+void main()
+{
+    // Rotate the corner around the center of the sprite.
+    vec2 halfSize = instanceBounds.zw * 0.5;
+    vec2 corner = vertex.xy * instanceBounds.zw - halfSize;
+    float c = cos(instanceRotation);
+    float s = sin(instanceRotation);
+    vec2 position = instanceBounds.xy + halfSize + vec2(corner.x * c - corner.y * s, corner.x * s + corner.y * c);
+    gl_Position = projection * vec4(position, 0.0, 1.0);
+    texCoords = mix(instanceRegion.xy, instanceRegion.zw, vertex.xy);
+    spriteColor = color * instanceColor;
+}
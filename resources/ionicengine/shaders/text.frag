@@ -1,12 +1,13 @@
 #version 330 core
 in vec2 texCoords;
+in vec4 spriteColor;
 out vec4 color;
 
-uniform sampler2D text;
-uniform vec4 inColor;
+uniform sampler2D image;
 
 void main()
 {
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, texCoords).r);
-    color = inColor * sampled;
-}
\ No newline at end of file
+    // The font atlas only stores coverage in the red channel.
+    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(image, texCoords).r);
+    color = spriteColor * sampled;
+}
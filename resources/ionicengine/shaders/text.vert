@@ -1,13 +1,15 @@
 #version 330 core
-layout (location = 0) in vec4 vertex;
+layout (location = 0) in vec2 vertex;
+layout (location = 1) in vec2 vertexTexCoords;
+layout (location = 2) in vec4 vertexColor;
 out vec2 texCoords;
+out vec4 spriteColor;
 
 uniform mat4 projection;
-uniform mat4 model;
-uniform mat4 transform;
 
 void main()
 {
-    gl_Position = projection * (transform * model * vec4(vertex.xy, 0.0, 1.0));
-    texCoords = vertex.zw;
-}
\ No newline at end of file
+    gl_Position = projection * vec4(vertex, 0.0, 1.0);
+    texCoords = vertexTexCoords;
+    spriteColor = vertexColor;
+}
@@ -0,0 +1,16 @@
+#version 330 core
+in vec2 texCoords;
+in vec4 spriteColor;
+out vec4 color;
+
+uniform sampler2D image;
+
+void main()
+{
+    // The font atlas stores signed distance fields in the red channel, the glyph edge is at 0.5.
+    float distance = texture(image, texCoords).r;
+    // The edge is smoothed over about one screen pixel whatever the size the text is drawn at.
+    float smoothing = max(fwidth(distance) * 0.7, 0.001);
+    float alpha = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
+    color = vec4(spriteColor.rgb, spriteColor.a * alpha);
+}
@@ -8,6 +8,7 @@
  */
 
 #include "../../include/ionicengine/gl/buffer.h"
+#include "../../include/ionicengine/gl/state.h"
 
 namespace ionicengine
 {
@@ -26,7 +27,7 @@ namespace ionicengine
 
 		void IONICENGINE_API bind(uint32_t id)
 		{
-			glBindVertexArray(id);
+			glstate::bind_vertex_array(id);
 		}
 
 		void IONICENGINE_API unbind()
@@ -46,7 +47,7 @@ namespace ionicengine
 
 		void IONICENGINE_API bind(uint32_t id)
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, id);
+			glstate::bind_array_buffer(id);
 		}
 
 		void IONICENGINE_API unbind()
@@ -66,7 +67,7 @@ namespace ionicengine
 
 		void IONICENGINE_API bind(uint32_t id)
 		{
-			glBindFramebuffer(GL_FRAMEBUFFER, id);
+			glstate::bind_framebuffer(id);
 		}
 
 		void IONICENGINE_API unbind()
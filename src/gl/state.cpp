@@ -0,0 +1,203 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../../include/ionicengine/gl/state.h"
+#include <algorithm>
+#include <array>
+
+#define IONIC_GL_UNKNOWN 0xFFFFFFFFu
+#define IONIC_GL_MAX_TRACKED_TEXTURE_UNITS 32
+
+namespace ionicengine
+{
+	namespace glstate
+	{
+		// The tracked capabilities, the others always reach the driver.
+		const std::array<GLenum, 5> TRACKED_CAPABILITIES{GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST,
+														 GL_STENCIL_TEST};
+
+		// Unknown values never match, so the first change of each kind always reaches the driver.
+		std::array<uint32_t, TRACKED_CAPABILITIES.size()> capabilities;
+		GLenum blend_source, blend_destination, blend_source_alpha, blend_destination_alpha;
+		uint32_t program, vertex_array, array_buffer, framebuffer;
+		GLenum texture_unit;
+		std::array<uint32_t, IONIC_GL_MAX_TRACKED_TEXTURE_UNITS> textures;
+		GLStateCounters counters;
+
+		struct Initializer
+		{
+			Initializer()
+			{
+				invalidate();
+			}
+		} initializer;
+
+		/*!
+		 * Compares the cached value with the requested one and updates it.
+		 * @return True if the call must reach the driver, else false.
+		 */
+		inline bool update(uint32_t &cached, uint32_t value)
+		{
+			if (cached == value)
+			{
+				counters.skipped++;
+				return false;
+			}
+			cached = value;
+			counters.issued++;
+			return true;
+		}
+
+		void IONICENGINE_API invalidate()
+		{
+			capabilities.fill(IONIC_GL_UNKNOWN);
+			blend_source = blend_destination = blend_source_alpha = blend_destination_alpha = IONIC_GL_UNKNOWN;
+			program = vertex_array = array_buffer = framebuffer = IONIC_GL_UNKNOWN;
+			texture_unit = IONIC_GL_UNKNOWN;
+			textures.fill(IONIC_GL_UNKNOWN);
+		}
+
+		void IONICENGINE_API set_enabled(GLenum capability, bool enabled)
+		{
+			auto tracked = std::find(TRACKED_CAPABILITIES.begin(), TRACKED_CAPABILITIES.end(), capability);
+			if (tracked == TRACKED_CAPABILITIES.end())
+				counters.issued++;
+			else if (!update(capabilities[tracked - TRACKED_CAPABILITIES.begin()], enabled ? 1 : 0))
+				return;
+			if (enabled)
+				glEnable(capability);
+			else
+				glDisable(capability);
+		}
+
+		void IONICENGINE_API enable(GLenum capability)
+		{
+			set_enabled(capability, true);
+		}
+
+		void IONICENGINE_API disable(GLenum capability)
+		{
+			set_enabled(capability, false);
+		}
+
+		void IONICENGINE_API blend_func(GLenum source_factor, GLenum destination_factor)
+		{
+			blend_func_separate(source_factor, destination_factor, source_factor, destination_factor);
+		}
+
+		void IONICENGINE_API blend_func_separate(GLenum source_color, GLenum destination_color, GLenum source_alpha,
+												 GLenum destination_alpha)
+		{
+			if (blend_source == source_color && blend_destination == destination_color &&
+				blend_source_alpha == source_alpha && blend_destination_alpha == destination_alpha)
+			{
+				counters.skipped++;
+				return;
+			}
+			blend_source = source_color;
+			blend_destination = destination_color;
+			blend_source_alpha = source_alpha;
+			blend_destination_alpha = destination_alpha;
+			counters.issued++;
+			glBlendFuncSeparate(source_color, destination_color, source_alpha, destination_alpha);
+		}
+
+		void IONICENGINE_API use_program(uint32_t id)
+		{
+			if (update(program, id))
+			{
+				counters.program_switches++;
+				glUseProgram(id);
+			}
+		}
+
+		void IONICENGINE_API bind_vertex_array(uint32_t vao)
+		{
+			if (update(vertex_array, vao))
+				glBindVertexArray(vao);
+		}
+
+		void IONICENGINE_API bind_array_buffer(uint32_t vbo)
+		{
+			if (update(array_buffer, vbo))
+				glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		}
+
+		void IONICENGINE_API bind_framebuffer(uint32_t fbo)
+		{
+			if (update(framebuffer, fbo))
+				glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		}
+
+		void IONICENGINE_API active_texture(GLenum unit)
+		{
+			if (update(texture_unit, unit))
+				glActiveTexture(unit);
+		}
+
+		void IONICENGINE_API bind_texture(uint32_t texture)
+		{
+			auto unit = texture_unit - GL_TEXTURE0;
+			// The active unit is unknown or not tracked, the bind always reaches the driver.
+			if (texture_unit == IONIC_GL_UNKNOWN || unit >= textures.size())
+			{
+				counters.issued++;
+				counters.texture_binds++;
+				glBindTexture(GL_TEXTURE_2D, texture);
+				return;
+			}
+			if (update(textures[unit], texture))
+			{
+				counters.texture_binds++;
+				glBindTexture(GL_TEXTURE_2D, texture);
+			}
+		}
+
+		void IONICENGINE_API bind_texture(GLenum unit, uint32_t texture)
+		{
+			active_texture(unit);
+			bind_texture(texture);
+		}
+
+		void IONICENGINE_API forget_texture(uint32_t texture)
+		{
+			for (auto &bound : textures)
+				if (bound == texture)
+					bound = 0;
+		}
+
+		void IONICENGINE_API forget_vertex_array(uint32_t vao)
+		{
+			if (vertex_array == vao)
+				vertex_array = 0;
+		}
+
+		void IONICENGINE_API forget_buffer(uint32_t buffer)
+		{
+			if (array_buffer == buffer)
+				array_buffer = 0;
+		}
+
+		void IONICENGINE_API forget_framebuffer(uint32_t fbo)
+		{
+			if (framebuffer == fbo)
+				framebuffer = 0;
+		}
+
+		const GLStateCounters &IONICENGINE_API get_counters()
+		{
+			return counters;
+		}
+
+		void IONICENGINE_API reset_counters()
+		{
+			counters = {};
+		}
+	}
+}
@@ -0,0 +1,300 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../../include/ionicengine/graphics/atlas.h"
+#include "../../include/ionicengine/ionicengine.h"
+#include <stb_image.h>
+#include <algorithm>
+
+namespace ionicengine
+{
+	/*
+	 * SKYLINEPACKER
+	 */
+
+	SkylinePacker::SkylinePacker(uint32_t width, uint32_t height) : _width(width), _height(height)
+	{
+		reset();
+	}
+
+	uint32_t SkylinePacker::get_width() const
+	{
+		return _width;
+	}
+
+	uint32_t SkylinePacker::get_height() const
+	{
+		return _height;
+	}
+
+	float SkylinePacker::get_occupancy() const
+	{
+		return static_cast<float>(_used_area) / (static_cast<float>(_width) * _height);
+	}
+
+	std::optional<uint32_t> SkylinePacker::fit(size_t index, uint32_t width, uint32_t height) const
+	{
+		auto x = _skyline[index].x;
+		if (x + width > _width)
+			return std::nullopt;
+		// The rectangle rests on the highest node it spans.
+		uint32_t y = 0;
+		int64_t width_left = width;
+		for (size_t i = index; width_left > 0; i++)
+		{
+			y = std::max(y, _skyline[i].y);
+			if (y + height > _height)
+				return std::nullopt;
+			width_left -= _skyline[i].width;
+		}
+		return y;
+	}
+
+	std::optional<std::pair<uint32_t, uint32_t>> SkylinePacker::pack(uint32_t width, uint32_t height)
+	{
+		if (width == 0 || height == 0)
+			return std::pair<uint32_t, uint32_t>{0, 0};
+
+		size_t best_index = _skyline.size();
+		uint32_t best_bottom = UINT32_MAX, best_width = UINT32_MAX, best_y = 0;
+		for (size_t i = 0; i < _skyline.size(); i++)
+		{
+			auto y = fit(i, width, height);
+			if (!y)
+				continue;
+			// Bottom-left: lowest resulting top edge first, then the narrowest node to limit the wasted space.
+			if (*y + height < best_bottom || (*y + height == best_bottom && _skyline[i].width < best_width))
+			{
+				best_index = i;
+				best_bottom = *y + height;
+				best_width = _skyline[i].width;
+				best_y = *y;
+			}
+		}
+		if (best_index == _skyline.size())
+			return std::nullopt;
+
+		auto x = _skyline[best_index].x;
+		_skyline.insert(_skyline.begin() + best_index, {x, best_y + height, width});
+
+		// Shrinks or removes the nodes now covered by the new one.
+		for (size_t i = best_index + 1; i < _skyline.size();)
+		{
+			auto &previous = _skyline[i - 1];
+			auto &node = _skyline[i];
+			if (node.x >= previous.x + previous.width)
+				break;
+			auto shrink = previous.x + previous.width - node.x;
+			if (node.width <= shrink)
+			{
+				_skyline.erase(_skyline.begin() + i);
+				continue;
+			}
+			node.x += shrink;
+			node.width -= shrink;
+			break;
+		}
+
+		// Merges the neighbours at the same height.
+		for (size_t i = 0; i + 1 < _skyline.size();)
+		{
+			if (_skyline[i].y == _skyline[i + 1].y)
+			{
+				_skyline[i].width += _skyline[i + 1].width;
+				_skyline.erase(_skyline.begin() + i + 1);
+			}
+			else
+				i++;
+		}
+
+		_used_area += static_cast<uint64_t>(width) * height;
+		return std::pair<uint32_t, uint32_t>{x, best_y};
+	}
+
+	void SkylinePacker::reset()
+	{
+		_skyline.clear();
+		_skyline.push_back({0, 0, _width});
+		_used_area = 0;
+	}
+
+	/*
+	 * TEXTUREATLAS
+	 */
+
+	TextureAtlas::TextureAtlas(uint32_t page_width, uint32_t page_height, uint32_t padding, uint32_t extrusion,
+							   TextureFilterMode filter_mode) : _page_width(page_width), _page_height(page_height),
+																_padding(padding), _extrusion(extrusion),
+																_filter_mode(filter_mode)
+	{}
+
+	TextureAtlas::~TextureAtlas()
+	{
+		clear();
+	}
+
+	uint32_t TextureAtlas::get_page_width() const
+	{
+		return _page_width;
+	}
+
+	uint32_t TextureAtlas::get_page_height() const
+	{
+		return _page_height;
+	}
+
+	uint32_t TextureAtlas::get_padding() const
+	{
+		return _padding;
+	}
+
+	uint32_t TextureAtlas::get_extrusion() const
+	{
+		return _extrusion;
+	}
+
+	size_t TextureAtlas::get_page_count() const
+	{
+		return _pages.size();
+	}
+
+	const Texture &TextureAtlas::get_page(size_t index) const
+	{
+		return _pages.at(index).texture;
+	}
+
+	TextureAtlas::Page &TextureAtlas::new_page()
+	{
+		uint32_t id;
+		glGenTextures(1, &id);
+		texture::bind(id);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _filter_mode);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _filter_mode);
+		// The page starts fully transparent, the padding around the images stays that way.
+		std::vector<unsigned char> blank(static_cast<size_t>(_page_width) * _page_height * 4, 0);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _page_width, _page_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, blank.data());
+		texture::unbind();
+
+		_pages.push_back({Texture{id, _page_width, _page_height, 4}, SkylinePacker{_page_width, _page_height}});
+		return _pages.back();
+	}
+
+	std::optional<AtlasEntry> TextureAtlas::load(const lambdacommon::ResourceName &name, const std::string &extension)
+	{
+		if (auto entry = get(name))
+			return *entry;
+		if (!get_resources_manager().does_resource_exist(name, extension))
+			return std::nullopt;
+
+		int width, height, channels;
+		auto image = stbi_load(get_resources_manager().get_resource_path(name, extension).to_string().c_str(), &width,
+							   &height, &channels, 4);
+		if (!image)
+			return std::nullopt;
+		auto entry = add(name, image, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+		stbi_image_free(image);
+		return entry;
+	}
+
+	std::optional<AtlasEntry>
+	TextureAtlas::add(const lambdacommon::ResourceName &name, const unsigned char *image, uint32_t width,
+					  uint32_t height)
+	{
+		auto handle = resource::intern(name);
+		if (auto entry = get(handle))
+			return *entry;
+		if (width == 0 || height == 0)
+			return std::nullopt;
+
+		// The slot holds the image, its extruded border on each side and the padding on the right and bottom.
+		uint32_t extruded_width = width + _extrusion * 2, extruded_height = height + _extrusion * 2;
+		uint32_t slot_width = extruded_width + _padding, slot_height = extruded_height + _padding;
+		if (slot_width > _page_width || slot_height > _page_height)
+		{
+			print_error("[IonicEngine] Cannot pack the image '" + name.to_string() +
+						"' in the atlas, it is larger than a page.");
+			return std::nullopt;
+		}
+
+		Page *page = nullptr;
+		std::optional<std::pair<uint32_t, uint32_t>> position;
+		for (auto &existing_page : _pages)
+		{
+			position = existing_page.packer.pack(slot_width, slot_height);
+			if (position)
+			{
+				page = &existing_page;
+				break;
+			}
+		}
+		if (page == nullptr)
+		{
+			page = &new_page();
+			position = page->packer.pack(slot_width, slot_height);
+		}
+
+		// Repeats the edge pixels outwards so that filtering at the image border samples the image itself.
+		std::vector<unsigned char> extruded(static_cast<size_t>(extruded_width) * extruded_height * 4);
+		for (uint32_t y = 0; y < extruded_height; y++)
+		{
+			auto source_y = static_cast<uint32_t>(
+					std::clamp(static_cast<int64_t>(y) - _extrusion, static_cast<int64_t>(0),
+							   static_cast<int64_t>(height) - 1));
+			for (uint32_t x = 0; x < extruded_width; x++)
+			{
+				auto source_x = static_cast<uint32_t>(
+						std::clamp(static_cast<int64_t>(x) - _extrusion, static_cast<int64_t>(0),
+								   static_cast<int64_t>(width) - 1));
+				std::copy_n(image + (static_cast<size_t>(source_y) * width + source_x) * 4, 4,
+							extruded.begin() + (static_cast<size_t>(y) * extruded_width + x) * 4);
+			}
+		}
+
+		page->texture.bind();
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, position->first, position->second, extruded_width, extruded_height, GL_RGBA,
+						GL_UNSIGNED_BYTE, extruded.data());
+		texture::unbind();
+
+		AtlasEntry entry{page->texture, page->texture.new_region(position->first + _extrusion,
+																 position->second + _extrusion, width, height)};
+		_entries.set(handle, entry);
+		return entry;
+	}
+
+	bool TextureAtlas::has(const lambdacommon::ResourceName &name) const
+	{
+		return has(resource::find(name));
+	}
+
+	bool TextureAtlas::has(ResourceHandle handle) const
+	{
+		return _entries.has(handle);
+	}
+
+	const AtlasEntry *TextureAtlas::get(ResourceHandle handle) const
+	{
+		return _entries.find(handle);
+	}
+
+	const AtlasEntry *TextureAtlas::get(const lambdacommon::ResourceName &name) const
+	{
+		return get(resource::find(name));
+	}
+
+	void TextureAtlas::clear()
+	{
+		for (auto &page : _pages)
+			page.texture.delete_texture();
+		_pages.clear();
+		_entries.clear();
+	}
+}
@@ -0,0 +1,305 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../../include/ionicengine/graphics/batch.h"
+#include "../../include/ionicengine/gl/buffer.h"
+#include "../../include/ionicengine/gl/state.h"
+#include <cstddef>
+
+namespace ionicengine
+{
+	SpriteBatch::SpriteBatch(size_t max_sprites) : _max_sprites(max_sprites)
+	{
+		_vertices.reserve(max_sprites * 4);
+
+		// Every quad is made of two triangles sharing the top-right and bottom-left vertices.
+		std::vector<uint32_t> indices;
+		indices.reserve(max_sprites * 6);
+		for (uint32_t i = 0; i < static_cast<uint32_t>(max_sprites); i++)
+		{
+			uint32_t base = i * 4;
+			indices.insert(indices.end(), {base, base + 2, base + 1, base + 1, base + 2, base + 3});
+		}
+
+		_vao = vao::generate();
+		_vbo = vbo::generate();
+		glGenBuffers(1, &_ebo);
+
+		vao::bind(_vao);
+		vbo::bind(_vbo);
+		glBufferData(GL_ARRAY_BUFFER, max_sprites * 4 * sizeof(SpriteVertex), nullptr, GL_STREAM_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
+							  reinterpret_cast<void *>(offsetof(SpriteVertex, x)));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
+							  reinterpret_cast<void *>(offsetof(SpriteVertex, u)));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
+							  reinterpret_cast<void *>(offsetof(SpriteVertex, r)));
+		// The element buffer binding is part of the VAO state, only the array buffer is unbound.
+		vao::unbind();
+		vbo::unbind();
+	}
+
+	SpriteBatch::~SpriteBatch()
+	{
+		glDeleteBuffers(1, &_ebo);
+		glDeleteBuffers(1, &_vbo);
+		glDeleteVertexArrays(1, &_vao);
+		glstate::forget_buffer(_vbo);
+		glstate::forget_vertex_array(_vao);
+	}
+
+	size_t SpriteBatch::get_max_sprites() const
+	{
+		return _max_sprites;
+	}
+
+	size_t SpriteBatch::get_pending_sprites() const
+	{
+		return _vertices.size() / 4;
+	}
+
+	bool SpriteBatch::is_empty() const
+	{
+		return _vertices.empty();
+	}
+
+	bool SpriteBatch::needs_flush(const Shader &shader, uint32_t texture) const
+	{
+		if (is_empty())
+			return false;
+		return _shader != shader || _texture != texture || get_pending_sprites() >= _max_sprites;
+	}
+
+	void SpriteBatch::push(const Shader &shader, uint32_t texture, const SpriteVertex quad[4])
+	{
+		if (is_empty())
+		{
+			// Uniform locations are only resolved when the shader changes.
+			if (_shader != shader)
+			{
+				_shader = shader;
+				_projection_location = shader.get_uniform_location("projection");
+				_image_location = shader.get_uniform_location("image");
+			}
+			_texture = texture;
+		}
+		_vertices.insert(_vertices.end(), quad, quad + 4);
+	}
+
+	bool SpriteBatch::flush(const glm::mat4 &projection)
+	{
+		if (is_empty())
+			return false;
+
+		_shader.use();
+		_shader.set_matrix_4f(_projection_location, projection);
+		_shader.set_integer(_image_location, 0);
+
+		glstate::bind_texture(GL_TEXTURE0, _texture);
+
+		vao::bind(_vao);
+		// Orphan the previous storage so the driver does not wait for the last draw to complete.
+		vbo::bind(_vbo);
+		glBufferData(GL_ARRAY_BUFFER, _max_sprites * 4 * sizeof(SpriteVertex), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, _vertices.size() * sizeof(SpriteVertex), _vertices.data());
+
+		// The bindings are left in place, the state cache skips them if the next flush uses the same ones.
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(get_pending_sprites() * 6), GL_UNSIGNED_INT, nullptr);
+
+		_vertices.clear();
+		return true;
+	}
+
+	SpriteInstancer::SpriteInstancer(uint32_t quad_vbo, size_t capacity) : _capacity(capacity == 0 ? 1 : capacity)
+	{
+		_vao = vao::generate();
+		_vbo = vbo::generate();
+
+		vao::bind(_vao);
+		// The unit quad corners, z is the texture coordinates index used by the image shader and is ignored here.
+		vbo::bind(quad_vbo);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
+
+		vbo::bind(_vbo);
+		glBufferData(GL_ARRAY_BUFFER, _capacity * sizeof(SpriteInstance), nullptr, GL_STREAM_DRAW);
+		const struct
+		{
+			GLint size;
+			size_t offset;
+		} attributes[] = {{4, offsetof(SpriteInstance, x)},
+						  {1, offsetof(SpriteInstance, rotation)},
+						  {4, offsetof(SpriteInstance, r)},
+						  {4, offsetof(SpriteInstance, region)}};
+		for (GLuint i = 0; i < 4; i++)
+		{
+			glEnableVertexAttribArray(i + 1);
+			glVertexAttribPointer(i + 1, attributes[i].size, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+								  reinterpret_cast<void *>(attributes[i].offset));
+			glVertexAttribDivisor(i + 1, 1);
+		}
+		vao::unbind();
+		vbo::unbind();
+	}
+
+	SpriteInstancer::~SpriteInstancer()
+	{
+		glDeleteBuffers(1, &_vbo);
+		glDeleteVertexArrays(1, &_vao);
+		glstate::forget_buffer(_vbo);
+		glstate::forget_vertex_array(_vao);
+	}
+
+	size_t SpriteInstancer::get_capacity() const
+	{
+		return _capacity;
+	}
+
+	bool SpriteInstancer::draw(const Shader &shader, uint32_t texture, const glm::mat4 &projection,
+							   const lambdacommon::Color &color, const SpriteInstance *instances, size_t count)
+	{
+		if (count == 0)
+			return false;
+
+		if (_shader != shader)
+		{
+			_shader = shader;
+			_projection_location = shader.get_uniform_location("projection");
+			_image_location = shader.get_uniform_location("image");
+			_color_location = shader.get_uniform_location("color");
+		}
+
+		_shader.use();
+		_shader.set_matrix_4f(_projection_location, projection);
+		_shader.set_integer(_image_location, 0);
+		_shader.set_color(_color_location, color);
+
+		glstate::bind_texture(GL_TEXTURE0, texture);
+
+		vao::bind(_vao);
+		vbo::bind(_vbo);
+		while (_capacity < count)
+			_capacity *= 2;
+		// Orphan the previous storage so the driver does not wait for the last draw to complete.
+		glBufferData(GL_ARRAY_BUFFER, _capacity * sizeof(SpriteInstance), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(SpriteInstance), instances);
+
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(count));
+		return true;
+	}
+
+	PrimitiveBatch::PrimitiveBatch(size_t max_vertices) : _max_vertices(max_vertices)
+	{
+		_triangles.reserve(max_vertices);
+
+		_vao = vao::generate();
+		_vbo = vbo::generate();
+
+		vao::bind(_vao);
+		vbo::bind(_vbo);
+		glBufferData(GL_ARRAY_BUFFER, max_vertices * sizeof(ColoredVertex), nullptr, GL_STREAM_DRAW);
+
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex),
+							  reinterpret_cast<void *>(offsetof(ColoredVertex, x)));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex),
+							  reinterpret_cast<void *>(offsetof(ColoredVertex, r)));
+		vao::unbind();
+		vbo::unbind();
+	}
+
+	PrimitiveBatch::~PrimitiveBatch()
+	{
+		glDeleteBuffers(1, &_vbo);
+		glDeleteVertexArrays(1, &_vao);
+		glstate::forget_buffer(_vbo);
+		glstate::forget_vertex_array(_vao);
+	}
+
+	size_t PrimitiveBatch::get_max_vertices() const
+	{
+		return _max_vertices;
+	}
+
+	bool PrimitiveBatch::is_empty() const
+	{
+		return _triangles.empty() && _lines.empty();
+	}
+
+	bool PrimitiveBatch::has_lines() const
+	{
+		return !_lines.empty();
+	}
+
+	bool PrimitiveBatch::can_fit(size_t count) const
+	{
+		return _triangles.size() + _lines.size() + count <= _max_vertices;
+	}
+
+	size_t PrimitiveBatch::get_pending_vertices() const
+	{
+		return _triangles.size() + _lines.size();
+	}
+
+	void PrimitiveBatch::push_triangles(const ColoredVertex *vertices, size_t count)
+	{
+		_triangles.insert(_triangles.end(), vertices, vertices + count);
+	}
+
+	void PrimitiveBatch::push_lines(const ColoredVertex *vertices, size_t count)
+	{
+		_lines.insert(_lines.end(), vertices, vertices + count);
+	}
+
+	uint32_t PrimitiveBatch::flush(Shader &shader, const glm::mat4 &projection)
+	{
+		if (is_empty())
+			return 0;
+
+		if (_shader != shader)
+		{
+			_shader = shader;
+			_projection_location = shader.get_uniform_location("projection");
+		}
+
+		shader.use();
+		shader.set_matrix_4f(_projection_location, projection);
+
+		vao::bind(_vao);
+		// Both primitive types live in the same stream: triangles first, then lines.
+		vbo::bind(_vbo);
+		glBufferData(GL_ARRAY_BUFFER, _max_vertices * sizeof(ColoredVertex), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, _triangles.size() * sizeof(ColoredVertex), _triangles.data());
+		glBufferSubData(GL_ARRAY_BUFFER, _triangles.size() * sizeof(ColoredVertex),
+						_lines.size() * sizeof(ColoredVertex), _lines.data());
+
+		uint32_t draw_calls = 0;
+		if (!_triangles.empty())
+		{
+			glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(_triangles.size()));
+			draw_calls++;
+		}
+		if (!_lines.empty())
+		{
+			glDrawArrays(GL_LINES, static_cast<GLint>(_triangles.size()), static_cast<GLsizei>(_lines.size()));
+			draw_calls++;
+		}
+
+		_triangles.clear();
+		_lines.clear();
+		return draw_calls;
+	}
+}
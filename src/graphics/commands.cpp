@@ -0,0 +1,125 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../../include/ionicengine/graphics/commands.h"
+#include <lambdacommon/maths.h>
+#include <algorithm>
+#include <cmath>
+
+#define IONIC_COMMAND_MIXED_BATCH UINT32_MAX
+#define IONIC_COMMAND_MAX_DEPTH 0xFFFFFFu
+
+namespace maths = lambdacommon::maths;
+
+namespace ionicengine
+{
+	std::vector<CommandQueue::Cell> &CommandQueue::get_grid(uint8_t layer)
+	{
+		for (auto &grid : _grids)
+			if (grid.layer == layer)
+				return grid.cells;
+		_grids.push_back({layer, std::vector<Cell>(_columns * _rows, Cell{0, 0})});
+		return _grids.back().cells;
+	}
+
+	void CommandQueue::set_bounds(uint32_t width, uint32_t height)
+	{
+		auto columns = maths::max(1u, (width + IONIC_COMMAND_CELL_SIZE - 1) / IONIC_COMMAND_CELL_SIZE);
+		auto rows = maths::max(1u, (height + IONIC_COMMAND_CELL_SIZE - 1) / IONIC_COMMAND_CELL_SIZE);
+		if (columns == _columns && rows == _rows)
+			return;
+		// The depths recorded so far no longer map to the cells, the queue must be empty.
+		_columns = columns;
+		_rows = rows;
+		_grids.clear();
+	}
+
+	void CommandQueue::push(uint8_t layer, uint64_t state, float min_x, float min_y, float max_x, float max_y,
+							RenderCommandType type, uint32_t first, uint32_t count)
+	{
+		uint32_t batch;
+		if (state == IONIC_COMMAND_UNIQUE_BATCH)
+			batch = _next_batch++;
+		else
+		{
+			auto entry = _batches.find(state);
+			if (entry == _batches.end())
+				entry = _batches.emplace(state, _next_batch++).first;
+			batch = entry->second;
+		}
+
+		// A command ending exactly on the edge of a cell does not touch the next one.
+		auto to_cell = [](float position, uint32_t cells)
+		{
+			return static_cast<uint32_t>(maths::clamp(position, 0.f, static_cast<float>(cells - 1)));
+		};
+		uint32_t first_column = to_cell(std::floor(min_x / IONIC_COMMAND_CELL_SIZE), _columns);
+		uint32_t first_row = to_cell(std::floor(min_y / IONIC_COMMAND_CELL_SIZE), _rows);
+		uint32_t last_column = maths::max(first_column, to_cell(std::ceil(max_x / IONIC_COMMAND_CELL_SIZE) - 1.f,
+															   _columns));
+		uint32_t last_row = maths::max(first_row, to_cell(std::ceil(max_y / IONIC_COMMAND_CELL_SIZE) - 1.f, _rows));
+
+		auto &cells = get_grid(layer);
+		uint32_t depth = 0;
+		for (uint32_t row = first_row; row <= last_row; row++)
+			for (uint32_t column = first_column; column <= last_column; column++)
+			{
+				const auto &cell = cells[row * _columns + column];
+				if (cell.depth != 0)
+					depth = maths::max(depth, cell.batch == batch ? cell.depth - 1 : cell.depth);
+			}
+		depth = maths::min(depth, IONIC_COMMAND_MAX_DEPTH);
+
+		for (uint32_t row = first_row; row <= last_row; row++)
+			for (uint32_t column = first_column; column <= last_column; column++)
+			{
+				auto &cell = cells[row * _columns + column];
+				if (cell.depth < depth + 1)
+					cell = {depth + 1, batch};
+				else if (cell.batch != batch)
+					cell.batch = IONIC_COMMAND_MIXED_BATCH;
+			}
+
+		uint64_t key = (static_cast<uint64_t>(layer) << 56) | (static_cast<uint64_t>(depth) << 32) | batch;
+		_commands.push_back({key, type, first, count});
+	}
+
+	const std::vector<RenderCommand> &CommandQueue::sort()
+	{
+		std::stable_sort(_commands.begin(), _commands.end(), [](const RenderCommand &a, const RenderCommand &b)
+		{
+			return a.key < b.key;
+		});
+		return _commands;
+	}
+
+	size_t CommandQueue::size() const
+	{
+		return _commands.size();
+	}
+
+	bool CommandQueue::is_empty() const
+	{
+		return _commands.empty();
+	}
+
+	size_t CommandQueue::get_batch_count() const
+	{
+		return _next_batch;
+	}
+
+	void CommandQueue::clear()
+	{
+		_commands.clear();
+		_batches.clear();
+		_next_batch = 0;
+		for (auto &grid : _grids)
+			std::fill(grid.cells.begin(), grid.cells.end(), Cell{0, 0});
+	}
+}
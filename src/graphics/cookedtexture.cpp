@@ -0,0 +1,377 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../../include/ionicengine/graphics/cookedtexture.h"
+#include "../../include/ionicengine/ionicengine.h"
+#include <stb_image.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+namespace ionicengine
+{
+	/*!
+	 * Gets the modification time and the size of a file.
+	 * @return True if the file exists, else false.
+	 */
+	bool get_file_stamp(const std::string &path, int64_t &mtime, uint64_t &size)
+	{
+		struct stat status{};
+		if (stat(path.c_str(), &status) != 0)
+			return false;
+		mtime = static_cast<int64_t>(status.st_mtime);
+		size = static_cast<uint64_t>(status.st_size);
+		return true;
+	}
+
+	/*!
+	 * Gets the number of bytes of a mip level of the specified format and size.
+	 */
+	uint64_t get_level_size(uint32_t format, uint32_t width, uint32_t height)
+	{
+		if (format == COOKED_RGBA8)
+			return static_cast<uint64_t>(width) * height * 4;
+		uint64_t blocks = static_cast<uint64_t>((width + 3) / 4) * ((height + 3) / 4);
+		return blocks * (format == COOKED_BC1 ? 8 : 16);
+	}
+
+	uint32_t CookOptions::get_flags() const
+	{
+		return (compress ? COOK_COMPRESS : 0u) | (mipmaps ? COOK_MIPMAPS : 0u);
+	}
+
+	/*
+	 * COOKEDTEXTURE
+	 */
+
+	bool CookedTexture::open(const std::string &path)
+	{
+		_header = nullptr;
+		_levels = nullptr;
+		if (!_file.open(path) || _file.get_size() < sizeof(CookedTextureHeader))
+			return false;
+
+		uint64_t file_size = _file.get_size();
+		auto header = reinterpret_cast<const CookedTextureHeader *>(_file.get_data());
+		// A 32-bit dimension has at most 32 mip levels.
+		if (header->magic != IONIC_COOKED_TEXTURE_MAGIC || header->version != IONIC_COOKED_TEXTURE_VERSION ||
+			header->format > COOKED_BC3 || header->width == 0 || header->height == 0 || header->mip_count == 0 ||
+			header->mip_count > 32 ||
+			file_size < sizeof(CookedTextureHeader) + header->mip_count * sizeof(CookedMipLevel))
+			return false;
+
+		// The levels are uploaded straight from the mapping, they must lie in the file and hold their whole size.
+		auto levels = reinterpret_cast<const CookedMipLevel *>(_file.get_data() + sizeof(CookedTextureHeader));
+		for (uint32_t i = 0; i < header->mip_count; i++)
+		{
+			const auto &level = levels[i];
+			if (level.offset > file_size || level.size > file_size - level.offset)
+				return false;
+			if (level.width != std::max(1u, header->width >> i) || level.height != std::max(1u, header->height >> i))
+				return false;
+			if (level.size != get_level_size(header->format, level.width, level.height))
+				return false;
+		}
+
+		_header = header;
+		_levels = levels;
+		return true;
+	}
+
+	const CookedTextureHeader &CookedTexture::get_header() const
+	{
+		return *_header;
+	}
+
+	const CookedMipLevel &CookedTexture::get_level(uint32_t level) const
+	{
+		return _levels[level];
+	}
+
+	const unsigned char *CookedTexture::get_level_data(uint32_t level) const
+	{
+		return _file.get_data() + _levels[level].offset;
+	}
+
+	bool CookedTexture::is_up_to_date(const std::string &source_path) const
+	{
+		int64_t mtime;
+		uint64_t size;
+		if (!get_file_stamp(source_path, mtime, size))
+			// Without the source, the cooked texture is all there is.
+			return true;
+		return mtime == _header->source_mtime && size == _header->source_size;
+	}
+
+	bool CookedTexture::was_cooked_with(const CookOptions &options) const
+	{
+		return _header->cook_flags == options.get_flags();
+	}
+
+	CookedTexture::operator bool() const
+	{
+		return _header != nullptr;
+	}
+
+	namespace texture
+	{
+		typedef std::array<std::array<uint8_t, 4>, 16> PixelBlock;
+
+		/*!
+		 * Halves an RGBA image with a box filter, odd edges are clamped.
+		 */
+		std::vector<uint8_t> downsample(const std::vector<uint8_t> &image, uint32_t width, uint32_t height)
+		{
+			uint32_t next_width = std::max(1u, width / 2), next_height = std::max(1u, height / 2);
+			std::vector<uint8_t> next(static_cast<size_t>(next_width) * next_height * 4);
+			for (uint32_t y = 0; y < next_height; y++)
+			{
+				uint32_t y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+				for (uint32_t x = 0; x < next_width; x++)
+				{
+					uint32_t x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						uint32_t sum = image[(static_cast<size_t>(y0) * width + x0) * 4 + c] +
+									   image[(static_cast<size_t>(y0) * width + x1) * 4 + c] +
+									   image[(static_cast<size_t>(y1) * width + x0) * 4 + c] +
+									   image[(static_cast<size_t>(y1) * width + x1) * 4 + c];
+						next[(static_cast<size_t>(y) * next_width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+					}
+				}
+			}
+			return next;
+		}
+
+		uint16_t to_rgb565(const std::array<int, 3> &color)
+		{
+			return static_cast<uint16_t>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+		}
+
+		std::array<int, 3> from_rgb565(uint16_t color)
+		{
+			int r = (color >> 11) & 0x1F, g = (color >> 5) & 0x3F, b = color & 0x1F;
+			return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+		}
+
+		/*!
+		 * Encodes the color of a block in the 4-color BC1 mode, the endpoints are the inset bounding box of the colors.
+		 */
+		void encode_color_block(const PixelBlock &block, uint8_t *output)
+		{
+			std::array<int, 3> min_color{255, 255, 255}, max_color{0, 0, 0};
+			for (const auto &pixel : block)
+				for (size_t c = 0; c < 3; c++)
+				{
+					min_color[c] = std::min(min_color[c], static_cast<int>(pixel[c]));
+					max_color[c] = std::max(max_color[c], static_cast<int>(pixel[c]));
+				}
+			for (size_t c = 0; c < 3; c++)
+			{
+				int inset = (max_color[c] - min_color[c]) / 16;
+				min_color[c] += inset;
+				max_color[c] -= inset;
+			}
+
+			auto color0 = to_rgb565(max_color), color1 = to_rgb565(min_color);
+			if (color0 < color1)
+				std::swap(color0, color1);
+
+			uint32_t indices = 0;
+			// Equal endpoints would switch to the 3-color mode, every pixel keeps index 0 instead.
+			if (color0 != color1)
+			{
+				auto c0 = from_rgb565(color0), c1 = from_rgb565(color1);
+				std::array<std::array<int, 3>, 4> palette{c0, c1};
+				for (size_t c = 0; c < 3; c++)
+				{
+					palette[2][c] = (2 * c0[c] + c1[c]) / 3;
+					palette[3][c] = (c0[c] + 2 * c1[c]) / 3;
+				}
+				for (size_t i = 0; i < 16; i++)
+				{
+					uint32_t best = 0;
+					int best_distance = INT32_MAX;
+					for (uint32_t p = 0; p < 4; p++)
+					{
+						int distance = 0;
+						for (size_t c = 0; c < 3; c++)
+						{
+							int delta = block[i][c] - palette[p][c];
+							distance += delta * delta;
+						}
+						if (distance < best_distance)
+						{
+							best_distance = distance;
+							best = p;
+						}
+					}
+					indices |= best << (i * 2);
+				}
+			}
+
+			output[0] = static_cast<uint8_t>(color0 & 0xFF);
+			output[1] = static_cast<uint8_t>(color0 >> 8);
+			output[2] = static_cast<uint8_t>(color1 & 0xFF);
+			output[3] = static_cast<uint8_t>(color1 >> 8);
+			for (size_t i = 0; i < 4; i++)
+				output[4 + i] = static_cast<uint8_t>((indices >> (i * 8)) & 0xFF);
+		}
+
+		/*!
+		 * Encodes the alpha of a block in the 8-value BC3 mode, the endpoints are the extreme alpha values.
+		 */
+		void encode_alpha_block(const PixelBlock &block, uint8_t *output)
+		{
+			int min_alpha = 255, max_alpha = 0;
+			for (const auto &pixel : block)
+			{
+				min_alpha = std::min(min_alpha, static_cast<int>(pixel[3]));
+				max_alpha = std::max(max_alpha, static_cast<int>(pixel[3]));
+			}
+
+			uint64_t indices = 0;
+			if (max_alpha != min_alpha)
+			{
+				std::array<int, 8> palette{max_alpha, min_alpha};
+				for (int i = 1; i < 7; i++)
+					palette[i + 1] = ((7 - i) * max_alpha + i * min_alpha) / 7;
+				for (size_t i = 0; i < 16; i++)
+				{
+					uint64_t best = 0;
+					int best_distance = INT32_MAX;
+					for (uint64_t p = 0; p < 8; p++)
+					{
+						int distance = std::abs(block[i][3] - palette[p]);
+						if (distance < best_distance)
+						{
+							best_distance = distance;
+							best = p;
+						}
+					}
+					indices |= best << (i * 3);
+				}
+			}
+
+			output[0] = static_cast<uint8_t>(max_alpha);
+			output[1] = static_cast<uint8_t>(min_alpha);
+			for (size_t i = 0; i < 6; i++)
+				output[2 + i] = static_cast<uint8_t>((indices >> (i * 8)) & 0xFF);
+		}
+
+		std::vector<uint8_t>
+		compress(const std::vector<uint8_t> &image, uint32_t width, uint32_t height, CookedTextureFormat format)
+		{
+			size_t block_size = format == COOKED_BC1 ? 8 : 16;
+			uint32_t blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+			std::vector<uint8_t> output(blocks_x * blocks_y * block_size);
+			PixelBlock block{};
+			for (uint32_t by = 0; by < blocks_y; by++)
+				for (uint32_t bx = 0; bx < blocks_x; bx++)
+				{
+					// The blocks past the edges repeat the last row and column.
+					for (uint32_t i = 0; i < 16; i++)
+					{
+						uint32_t x = std::min(bx * 4 + i % 4, width - 1), y = std::min(by * 4 + i / 4, height - 1);
+						std::copy_n(image.begin() + (static_cast<size_t>(y) * width + x) * 4, 4, block[i].begin());
+					}
+					auto destination = output.data() + (static_cast<size_t>(by) * blocks_x + bx) * block_size;
+					if (format == COOKED_BC3)
+					{
+						encode_alpha_block(block, destination);
+						destination += 8;
+					}
+					encode_color_block(block, destination);
+				}
+			return output;
+		}
+
+		std::string IONICENGINE_API get_cooked_extension(const std::string &extension)
+		{
+			if (extension.empty() || extension == IONIC_COOKED_TEXTURE_EXTENSION)
+				return IONIC_COOKED_TEXTURE_EXTENSION;
+			return extension + "." + IONIC_COOKED_TEXTURE_EXTENSION;
+		}
+
+		bool IONICENGINE_API
+		cook(const std::string &source_path, const std::string &output_path, const CookOptions &options)
+		{
+			CookedTextureHeader header{};
+			if (!get_file_stamp(source_path, header.source_mtime, header.source_size))
+				return false;
+
+			int width, height, channels;
+			auto pixels = stbi_load(source_path.c_str(), &width, &height, &channels, 4);
+			if (!pixels)
+				return false;
+			std::vector<uint8_t> image(pixels, pixels + static_cast<size_t>(width) * height * 4);
+			stbi_image_free(pixels);
+
+			header.magic = IONIC_COOKED_TEXTURE_MAGIC;
+			header.version = IONIC_COOKED_TEXTURE_VERSION;
+			header.format = COOKED_RGBA8;
+			if (options.compress)
+			{
+				bool opaque = true;
+				for (size_t i = 3; i < image.size() && opaque; i += 4)
+					opaque = image[i] == 255;
+				header.format = opaque ? COOKED_BC1 : COOKED_BC3;
+			}
+			header.width = static_cast<uint32_t>(width);
+			header.height = static_cast<uint32_t>(height);
+			header.channels = static_cast<uint32_t>(channels);
+			header.cook_flags = options.get_flags();
+
+			std::vector<std::vector<uint8_t>> levels_data;
+			std::vector<CookedMipLevel> levels;
+			uint32_t level_width = header.width, level_height = header.height;
+			while (true)
+			{
+				if (header.format == COOKED_RGBA8)
+					levels_data.push_back(image);
+				else
+					levels_data.push_back(compress(image, level_width, level_height,
+												   static_cast<CookedTextureFormat>(header.format)));
+				levels.push_back({level_width, level_height, 0, levels_data.back().size()});
+				if (!options.mipmaps || (level_width == 1 && level_height == 1))
+					break;
+				image = downsample(image, level_width, level_height);
+				level_width = std::max(1u, level_width / 2);
+				level_height = std::max(1u, level_height / 2);
+			}
+			header.mip_count = static_cast<uint32_t>(levels.size());
+
+			// Each level starts 16-byte aligned.
+			uint64_t offset = sizeof(CookedTextureHeader) + levels.size() * sizeof(CookedMipLevel);
+			for (auto &level : levels)
+			{
+				offset = (offset + 15) & ~static_cast<uint64_t>(15);
+				level.offset = offset;
+				offset += level.size;
+			}
+
+			std::ofstream output{output_path, std::ios::binary | std::ios::trunc};
+			if (!output)
+				return false;
+			output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+			output.write(reinterpret_cast<const char *>(levels.data()), levels.size() * sizeof(CookedMipLevel));
+			const char padding[16]{};
+			for (size_t i = 0; i < levels.size(); i++)
+			{
+				auto position = static_cast<uint64_t>(output.tellp());
+				output.write(padding, levels[i].offset - position);
+				output.write(reinterpret_cast<const char *>(levels_data[i].data()), levels_data[i].size());
+			}
+			return static_cast<bool>(output);
+		}
+	}
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../../include/ionicengine/graphics/drawlist.h"
+
+namespace ionicengine
+{
+	const Dimension2D_u32 &DrawList::get_framebuffer_size() const
+	{
+		return _framebuffer_size;
+	}
+
+	const Dimension2D_u32 &DrawList::get_viewport_size() const
+	{
+		return _viewport_size;
+	}
+
+	void DrawList::set_viewport_size(const Dimension2D_u32 &size)
+	{
+		_viewport_size = size;
+	}
+
+	const lambdacommon::Color &DrawList::get_background_color() const
+	{
+		return _background_color;
+	}
+
+	void DrawList::set_background_color(const lambdacommon::Color &color)
+	{
+		_background_color = color;
+	}
+
+	size_t DrawList::size() const
+	{
+		return _commands.size();
+	}
+
+	bool DrawList::is_empty() const
+	{
+		return _commands.empty();
+	}
+
+	void DrawList::replay(Graphics *graphics) const
+	{
+		for (const auto &command : _commands)
+		{
+			switch (command.type)
+			{
+				case DRAW_COLOR:
+					graphics->set_color(_colors[command.index]);
+					break;
+				case DRAW_TRANSFORM:
+					graphics->set_transform(_transforms[command.index]);
+					break;
+				case DRAW_LAYER:
+					graphics->set_layer(static_cast<uint8_t>(command.index));
+					break;
+				case DRAW_BLEND_MODE:
+					graphics->set_blend_mode(static_cast<BlendMode>(command.index));
+					break;
+				case DRAW_FLUSH:
+					graphics->flush();
+					break;
+				case DRAW_LINE:
+				{
+					const auto &line = _rectangles[command.index];
+					graphics->draw_line_2d(line.x, line.y, line.z, line.w);
+					break;
+				}
+				case DRAW_QUAD:
+				{
+					const auto &quad = _rectangles[command.index];
+					graphics->draw_quad(quad.x, quad.y, quad.z, quad.w);
+					break;
+				}
+				case DRAW_QUAD_OUTLINE:
+				{
+					const auto &quad = _rectangles[command.index];
+					graphics->draw_quad_outline(quad.x, quad.y, quad.z, quad.w);
+					break;
+				}
+				case DRAW_IMAGE:
+				{
+					const auto &image = _images[command.index];
+					if (image.texture)
+						graphics->draw_image(*image.texture, image.x, image.y, image.width, image.height, image.region);
+					else
+						graphics->draw_image(image.handle, image.x, image.y, image.width, image.height, image.region);
+					break;
+				}
+				case DRAW_INSTANCES:
+				{
+					const auto &draw = _instanced_draws[command.index];
+					graphics->draw_image_instanced(draw.texture, _instances.data() + draw.first, draw.count);
+					break;
+				}
+				case DRAW_TEXT:
+				{
+					const auto &text = _texts[command.index];
+					graphics->draw_text(*text.layout, text.x, text.y, text.max_height, text.scale);
+					break;
+				}
+			}
+		}
+		graphics->reset_transform();
+		graphics->set_layer(0);
+		graphics->set_blend_mode(BLEND_ALPHA);
+		graphics->flush();
+	}
+
+	void DrawList::clear()
+	{
+		_commands.clear();
+		_colors.clear();
+		_transforms.clear();
+		_rectangles.clear();
+		_images.clear();
+		_instanced_draws.clear();
+		_instances.clear();
+		_texts.clear();
+	}
+
+	RecordingGraphics::RecordingGraphics(const Dimension2D_u32 &framebuffer_size) : Graphics(framebuffer_size)
+	{}
+
+	void RecordingGraphics::record_state()
+	{
+		if (!_state_recorded || color != _recorded_color)
+		{
+			_recorded_color = color;
+			_list->_colors.push_back(color);
+			_list->_commands.push_back({DRAW_COLOR, static_cast<uint32_t>(_list->_colors.size() - 1)});
+		}
+		if (!_state_recorded || _transform != _recorded_transform)
+		{
+			_recorded_transform = _transform;
+			_list->_transforms.push_back(_transform);
+			_list->_commands.push_back({DRAW_TRANSFORM, static_cast<uint32_t>(_list->_transforms.size() - 1)});
+		}
+		if (!_state_recorded || _layer != _recorded_layer)
+		{
+			_recorded_layer = _layer;
+			_list->_commands.push_back({DRAW_LAYER, _layer});
+		}
+		if (!_state_recorded || _blend_mode != _recorded_blend_mode)
+		{
+			_recorded_blend_mode = _blend_mode;
+			_list->_commands.push_back({DRAW_BLEND_MODE, static_cast<uint32_t>(_blend_mode)});
+		}
+		_state_recorded = true;
+	}
+
+	void RecordingGraphics::record(DrawCommandType type, size_t index)
+	{
+		_list->_commands.push_back({type, static_cast<uint32_t>(index)});
+	}
+
+	void RecordingGraphics::begin(DrawList &list)
+	{
+		_list = &list;
+		_list->clear();
+		_list->_framebuffer_size = _framebuffer_size;
+		_state_recorded = false;
+		reset_transform();
+		_layer = 0;
+		_blend_mode = BLEND_ALPHA;
+	}
+
+	void RecordingGraphics::flush()
+	{
+		if (_list != nullptr)
+			record(DRAW_FLUSH, 0);
+	}
+
+	void RecordingGraphics::set_color(const lambdacommon::Color &color)
+	{
+		this->color = color;
+	}
+
+	void RecordingGraphics::draw_line_2d(float x, float y, float x2, float y2)
+	{
+		record_state();
+		_list->_rectangles.emplace_back(x, y, x2, y2);
+		record(DRAW_LINE, _list->_rectangles.size() - 1);
+	}
+
+	void RecordingGraphics::draw_quad(float x, float y, float width, float height)
+	{
+		record_state();
+		_list->_rectangles.emplace_back(x, y, width, height);
+		record(DRAW_QUAD, _list->_rectangles.size() - 1);
+	}
+
+	void RecordingGraphics::draw_quad_outline(float x, float y, float width, float height)
+	{
+		record_state();
+		_list->_rectangles.emplace_back(x, y, width, height);
+		record(DRAW_QUAD_OUTLINE, _list->_rectangles.size() - 1);
+	}
+
+	void RecordingGraphics::draw_image(ResourceHandle texture, float x, float y, float width, float height,
+									   const TextureRegion &region)
+	{
+		record_state();
+		_list->_images.push_back({std::nullopt, texture, x, y, width, height, region});
+		record(DRAW_IMAGE, _list->_images.size() - 1);
+	}
+
+	void RecordingGraphics::draw_image(const Texture &texture, float x, float y, float width, float height,
+									   const TextureRegion &region)
+	{
+		if (!texture)
+			return;
+		record_state();
+		_list->_images.push_back({texture, {}, x, y, width, height, region});
+		record(DRAW_IMAGE, _list->_images.size() - 1);
+	}
+
+	void RecordingGraphics::draw_image_instanced(const Texture &texture, const SpriteInstance *instances, size_t count)
+	{
+		if (count == 0)
+			return;
+		record_state();
+		_list->_instanced_draws.push_back({texture, _list->_instances.size(), count});
+		_list->_instances.insert(_list->_instances.end(), instances, instances + count);
+		record(DRAW_INSTANCES, _list->_instanced_draws.size() - 1);
+	}
+
+	void RecordingGraphics::draw_text(const TextLayout &layout, int x, int y, uint32_t maxHeight, float scale)
+	{
+		record_state();
+		// Cached layouts are shared, the others are copied.
+		auto shared_layout = layout.weak_from_this().lock();
+		if (!shared_layout)
+			shared_layout = std::make_shared<const TextLayout>(layout);
+		_list->_texts.push_back({std::move(shared_layout), x, y, maxHeight, scale});
+		record(DRAW_TEXT, _list->_texts.size() - 1);
+	}
+}
@@ -10,10 +10,27 @@
 #include "../../include/ionicengine/graphics/font.h"
 #include "../../include/ionicengine/ionicengine.h"
 #include "../../include/ionicengine/graphics/textures.h"
+#include "../../include/ionicengine/graphics/atlas.h"
+#include "../../include/ionicengine/graphics/textlayout.h"
+#include "../../include/ionicengine/gl/state.h"
+#include "../../include/ionicengine/mappedfile.h"
+#include "../../include/ionicengine/threadpool.h"
+#include "../../include/ionicengine/profiler.h"
+#include "../../include/ionicengine/tracing.h"
 //#include <harfbuzz/hb.h>
 //#include <harfbuzz/hb-ft.h>
 #include <lambdacommon/maths.h>
-#include <sstream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <bitset>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
 
 namespace maths = lambdacommon::maths;
 
@@ -22,45 +39,888 @@ namespace ionicengine
 	bool Character::operator==(const Character &rhs) const
 	{
 		return codepoint == rhs.codepoint &&
-			   texture_id == rhs.texture_id &&
+			   page == rhs.page &&
 			   advance == rhs.advance;
 	}
 
 	bool Character::operator<(const Character &rhs) const
 	{
-		return std::tie(codepoint, texture_id, advance) < std::tie(rhs.codepoint, rhs.texture_id, rhs.advance);
+		return std::tie(codepoint, page, advance) < std::tie(rhs.codepoint, rhs.page, rhs.advance);
 	}
 
-	Font::Font(uint32_t textureId, std::pair<uint32_t, uint32_t> textureSize,
-			   const std::map<char, Character> &charactersMap, uint32_t size, uint32_t tabSize)
-			: _texture_id(textureId),
-			  _texture_size(textureSize),
-			  _chars(charactersMap),
+	namespace utf8
+	{
+		char32_t IONICENGINE_API decode(const std::string &text, size_t &offset)
+		{
+			auto lead = static_cast<unsigned char>(text[offset]);
+			if (lead < 0x80)
+			{
+				offset++;
+				return lead;
+			}
+
+			size_t length;
+			char32_t codepoint;
+			if ((lead & 0xE0) == 0xC0)
+			{
+				length = 2;
+				codepoint = lead & 0x1Fu;
+			}
+			else if ((lead & 0xF0) == 0xE0)
+			{
+				length = 3;
+				codepoint = lead & 0x0Fu;
+			}
+			else if ((lead & 0xF8) == 0xF0)
+			{
+				length = 4;
+				codepoint = lead & 0x07u;
+			}
+			else
+			{
+				offset++;
+				return 0xFFFD;
+			}
+
+			if (offset + length > text.size())
+			{
+				offset++;
+				return 0xFFFD;
+			}
+			for (size_t i = 1; i < length; i++)
+			{
+				auto continuation = static_cast<unsigned char>(text[offset + i]);
+				if ((continuation & 0xC0) != 0x80)
+				{
+					offset++;
+					return 0xFFFD;
+				}
+				codepoint = (codepoint << 6) | (continuation & 0x3Fu);
+			}
+			offset += length;
+			return codepoint;
+		}
+
+		void IONICENGINE_API append(std::string &text, char32_t codepoint)
+		{
+			if (codepoint < 0x80)
+				text += static_cast<char>(codepoint);
+			else if (codepoint < 0x800)
+			{
+				text += static_cast<char>(0xC0 | (codepoint >> 6));
+				text += static_cast<char>(0x80 | (codepoint & 0x3F));
+			}
+			else if (codepoint < 0x10000)
+			{
+				text += static_cast<char>(0xE0 | (codepoint >> 12));
+				text += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+				text += static_cast<char>(0x80 | (codepoint & 0x3F));
+			}
+			else if (codepoint < 0x110000)
+			{
+				text += static_cast<char>(0xF0 | (codepoint >> 18));
+				text += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+				text += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+				text += static_cast<char>(0x80 | (codepoint & 0x3F));
+			}
+		}
+
+		size_t IONICENGINE_API previous(const std::string &text, size_t offset)
+		{
+			// Continuation bytes are skipped, at most three of them belong to the same codepoint.
+			size_t start = offset - 1;
+			while (start > 0 && offset - start < 4 && (static_cast<unsigned char>(text[start]) & 0xC0) == 0x80)
+				start--;
+			return start;
+		}
+	}
+
+	// Incremented once per frame, the pages used during the current or the previous frame are not evicted:
+	// with a render thread, the previous frame may still be drawn while the next one is recorded.
+	static std::atomic<uint64_t> font_frame{1};
+
+	/*!
+	 * Header at the start of a font cache file, followed by the glyphs then the pixels of every page.
+	 */
+	struct FontCacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint32_t page_size;
+		uint32_t page_count;
+		uint32_t glyph_count;
+		uint32_t reserved;
+	};
+
+	/*!
+	 * A glyph as stored in a font cache file, the glyphs of a page are stored in the order they were packed.
+	 */
+	struct FontCacheGlyph
+	{
+		uint32_t codepoint;
+		uint32_t page;
+		int32_t width, height;
+		int32_t x, y;
+		int32_t bearing_x, bearing_y;
+		uint32_t advance;
+		uint32_t reserved;
+	};
+
+	/*!
+	 * Computes the key of the cache of a font: the FNV-1a hash of the font file mixed with the rasterization settings.
+	 * @return The key, or nothing if the font file cannot be read.
+	 */
+	static std::optional<uint64_t> get_font_cache_key(const std::string &path, uint32_t size, uint32_t sdf_spread)
+	{
+		MappedFile file{path};
+		if (!file)
+			return std::nullopt;
+
+		uint64_t hash = 0xCBF29CE484222325ull;
+		auto mix = [&hash](const unsigned char *data, size_t length)
+		{
+			for (size_t i = 0; i < length; i++)
+			{
+				hash ^= data[i];
+				hash *= 0x100000001B3ull;
+			}
+		};
+		mix(file.get_data(), file.get_size());
+		uint32_t settings[] = {size, IONIC_FONT_PAGE_SIZE, static_cast<uint32_t>(FT_LOAD_RENDER),
+							   IONIC_FONT_CACHE_VERSION, sdf_spread};
+		mix(reinterpret_cast<const unsigned char *>(settings), sizeof(settings));
+		return hash;
+	}
+
+	// FreeType faces sharing a library must be created and destroyed one at a time.
+	static std::mutex face_mutex;
+
+	/*!
+	 * A glyph rendered by FreeType, not packed in the atlas yet.
+	 */
+	struct GlyphBitmap
+	{
+		Character character;
+		// Tightly packed rows of coverage values.
+		std::vector<unsigned char> pixels;
+	};
+
+	/*!
+	 * Computes the squared euclidean distance transform of a row or a column (Felzenszwalb & Huttenlocher).
+	 * @param f The input squared distances, read with the specified stride.
+	 * @param stride The distance between two values.
+	 * @param n The number of values.
+	 * @param d The output squared distances.
+	 */
+	static void distance_transform(float *f, size_t stride, size_t n, std::vector<float> &d, std::vector<size_t> &v,
+								   std::vector<float> &z)
+	{
+		constexpr float infinity = 1e20f;
+		size_t k = 0;
+		v[0] = 0;
+		z[0] = -infinity;
+		z[1] = infinity;
+		for (size_t q = 1; q < n; q++)
+		{
+			float s;
+			while (true)
+			{
+				auto p = v[k];
+				s = ((f[q * stride] + q * q) - (f[p * stride] + p * p)) / (2.f * q - 2.f * p);
+				if (s > z[k] || k == 0)
+					break;
+				k--;
+			}
+			if (s <= z[k])
+			{
+				// Only reached with k == 0, the first parabola is replaced.
+				v[0] = q;
+				z[1] = infinity;
+				continue;
+			}
+			k++;
+			v[k] = q;
+			z[k] = s;
+			z[k + 1] = infinity;
+		}
+		k = 0;
+		for (size_t q = 0; q < n; q++)
+		{
+			while (z[k + 1] < q)
+				k++;
+			auto p = static_cast<float>(v[k]);
+			d[q] = (q - p) * (q - p) + f[v[k] * stride];
+		}
+		for (size_t q = 0; q < n; q++)
+			f[q * stride] = d[q];
+	}
+
+	/*!
+	 * Computes in place the squared distance of every cell of a grid to the closest cell at 0.
+	 */
+	static void distance_transform(std::vector<float> &grid, size_t width, size_t height)
+	{
+		size_t length = maths::max(width, height);
+		std::vector<float> d(length), z(length + 1);
+		std::vector<size_t> v(length);
+		for (size_t x = 0; x < width; x++)
+			distance_transform(grid.data() + x, width, height, d, v, z);
+		for (size_t y = 0; y < height; y++)
+			distance_transform(grid.data() + y * width, 1, width, d, v, z);
+	}
+
+	/*!
+	 * Converts a coverage bitmap into a signed distance field with a margin of the spread on every side.
+	 * A value of 128 is on the edge of the glyph, 255 is the spread or more inside and 0 the spread or more outside.
+	 * @param glyph The glyph to convert, its size and bearing are updated to include the margin.
+	 */
+	static void make_signed_distance_field(GlyphBitmap &glyph, uint32_t spread)
+	{
+		constexpr float infinity = 1e20f;
+		size_t source_width = glyph.character.size.x, source_height = glyph.character.size.y;
+		size_t width = source_width + 2 * spread, height = source_height + 2 * spread;
+
+		std::vector<float> outside(width * height, infinity), inside(width * height, 0.f);
+		for (size_t y = 0; y < source_height; y++)
+			for (size_t x = 0; x < source_width; x++)
+			{
+				if (glyph.pixels[y * source_width + x] < 128)
+					continue;
+				auto index = (y + spread) * width + x + spread;
+				outside[index] = 0.f;
+				inside[index] = infinity;
+			}
+		distance_transform(outside, width, height);
+		distance_transform(inside, width, height);
+
+		std::vector<unsigned char> field(width * height);
+		for (size_t i = 0; i < field.size(); i++)
+		{
+			// Positive outside the glyph, negative inside.
+			auto distance = std::sqrt(outside[i]) - std::sqrt(inside[i]);
+			auto value = 0.5f - distance / (2.f * spread);
+			field[i] = static_cast<unsigned char>(maths::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+		}
+
+		glyph.pixels = std::move(field);
+		glyph.character.size = {static_cast<int32_t>(width), static_cast<int32_t>(height)};
+		glyph.character.bearing.x -= spread;
+		glyph.character.bearing.y += spread;
+	}
+
+	/*!
+	 * Renders a glyph, a face must only be used by one thread at a time.
+	 * @param face The face to render with.
+	 * @param codepoint The codepoint of the glyph.
+	 * @param sdf_spread The spread of the signed distance field to generate, 0 to keep the coverage bitmap.
+	 * @return The rendered glyph, empty if the font doesn't provide it.
+	 */
+	static GlyphBitmap render_glyph(FT_Face face, char32_t codepoint, uint32_t sdf_spread)
+	{
+		GlyphBitmap glyph{{codepoint, {0, 0}, {0, 0}, {0, 0}, 0, 0}, {}};
+		// The codepoints that the font doesn't provide would all render as the same missing glyph.
+		if (codepoint != 0 && FT_Get_Char_Index(face, codepoint) == 0)
+			return glyph;
+		if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER))
+		{
+			print_error("Failed to load Glyph '" + std::to_string(codepoint) + "'.");
+			return glyph;
+		}
+
+		FT_GlyphSlot g = face->glyph;
+		glyph.character.bearing = {g->bitmap_left, g->bitmap_top};
+		glyph.character.advance = static_cast<uint32_t>(g->advance.x);
+		if (g->bitmap.width == 0 || g->bitmap.rows == 0)
+			return glyph;
+
+		glyph.character.size = {g->bitmap.width, g->bitmap.rows};
+		glyph.pixels.resize(static_cast<size_t>(g->bitmap.width) * g->bitmap.rows);
+		for (uint32_t row = 0; row < g->bitmap.rows; row++)
+			std::copy_n(g->bitmap.buffer + row * g->bitmap.pitch, g->bitmap.width,
+						glyph.pixels.begin() + row * g->bitmap.width);
+		if (sdf_spread != 0)
+			make_signed_distance_field(glyph, sdf_spread);
+		return glyph;
+	}
+
+	/*!
+	 * A page of a font atlas, glyphs are packed in it when they are first used.
+	 * The pixels are kept CPU-side to be written to the cache, the texture is synced when the page is drawn.
+	 */
+	struct FontPage
+	{
+		uint32_t texture;
+		SkylinePacker packer;
+		uint64_t last_use;
+		std::vector<unsigned char> pixels;
+		// The glyphs in the order they were packed, replaying it restores the packer state.
+		std::vector<char32_t> glyphs;
+		// Rows modified since the last sync.
+		uint32_t dirty_begin, dirty_end;
+	};
+
+	class FontData
+	{
+	private:
+		// Keeps FreeType alive as long as a face is in use.
+		std::shared_ptr<FT_LibraryRec_> _library;
+		std::string _path;
+		uint32_t _size;
+		// 0 for coverage bitmaps, else the spread of the signed distance fields.
+		uint32_t _sdf_spread;
+		// Opened on the first glyph missing from the cache.
+		FT_Face _face = nullptr;
+		// Shared by the faces of the parallel rasterization.
+		MappedFile _file;
+		bool _face_failed = false;
+		std::string _cache_path;
+		uint64_t _cache_key = 0;
+		bool _cache_dirty = false;
+		std::array<Character, IONIC_FONT_DIRECT_GLYPHS> _direct_chars{};
+		std::bitset<IONIC_FONT_DIRECT_GLYPHS> _direct_loaded;
+		std::unordered_map<char32_t, Character> _chars;
+		std::vector<FontPage> _pages;
+		// Guards the glyphs and the pages, a font may be laid out and drawn from different threads.
+		std::mutex _mutex;
+
+		uint32_t new_page()
+		{
+			_pages.push_back({0, SkylinePacker{IONIC_FONT_PAGE_SIZE, IONIC_FONT_PAGE_SIZE}, font_frame,
+							  std::vector<unsigned char>(static_cast<size_t>(IONIC_FONT_PAGE_SIZE) * IONIC_FONT_PAGE_SIZE,
+														 0), {}, 0, IONIC_FONT_PAGE_SIZE});
+			return static_cast<uint32_t>(_pages.size() - 1);
+		}
+
+		void set_character(const Character &character)
+		{
+			if (character.codepoint < IONIC_FONT_DIRECT_GLYPHS)
+			{
+				_direct_chars[character.codepoint] = character;
+				_direct_loaded[character.codepoint] = true;
+			}
+			else
+				_chars[character.codepoint] = character;
+		}
+
+		/*!
+		 * Drops every glyph of a page so the page can be packed again from scratch.
+		 * @param page The index of the page.
+		 */
+		void evict(uint32_t page)
+		{
+			auto is_evicted = [page](const Character &character)
+			{
+				return character.size.x != 0 && character.size.y != 0 && character.page == page;
+			};
+			for (size_t i = 0; i < _direct_chars.size(); i++)
+				if (_direct_loaded[i] && is_evicted(_direct_chars[i]))
+					_direct_loaded[i] = false;
+			for (auto it = _chars.begin(); it != _chars.end();)
+			{
+				if (is_evicted(it->second))
+					it = _chars.erase(it);
+				else
+					++it;
+			}
+
+			// The page is cleared so the linear filtering around the new glyphs only samples empty texels.
+			auto &evicted = _pages[page];
+			evicted.packer.reset();
+			evicted.glyphs.clear();
+			std::fill(evicted.pixels.begin(), evicted.pixels.end(), 0);
+			evicted.dirty_begin = 0;
+			evicted.dirty_end = IONIC_FONT_PAGE_SIZE;
+		}
+
+		/*!
+		 * Reserves a place for a glyph, evicting the least recently used page when the pages are full.
+		 * @return The page index and the position of the reserved place.
+		 */
+		std::optional<std::tuple<uint32_t, uint32_t, uint32_t>> allocate(uint32_t width, uint32_t height)
+		{
+			if (width > IONIC_FONT_PAGE_SIZE || height > IONIC_FONT_PAGE_SIZE)
+				return std::nullopt;
+
+			for (uint32_t page = 0; page < _pages.size(); page++)
+			{
+				if (auto place = _pages[page].packer.pack(width, height))
+					return std::make_tuple(page, place->first, place->second);
+			}
+
+			// A page used during the last two frames may still be referenced by the pending draws,
+			// the limit is exceeded rather than overwriting it.
+			uint32_t page;
+			auto lru = std::min_element(_pages.begin(), _pages.end(), [](const FontPage &a, const FontPage &b)
+			{
+				return a.last_use < b.last_use;
+			});
+			if (_pages.size() < IONIC_FONT_MAX_PAGES || lru == _pages.end() || lru->last_use + 1 >= font_frame)
+				page = new_page();
+			else
+			{
+				page = static_cast<uint32_t>(lru - _pages.begin());
+				evict(page);
+			}
+
+			auto place = _pages[page].packer.pack(width, height);
+			return std::make_tuple(page, place->first, place->second);
+		}
+
+		bool open_face()
+		{
+			if (_face || _face_failed)
+				return _face != nullptr;
+
+			std::lock_guard<std::mutex> lock{face_mutex};
+			if (FT_New_Face(_library.get(), _path.c_str(), 0, &_face) == 0)
+			{
+				if (FT_Select_Charmap(_face, FT_ENCODING_UNICODE) == 0)
+				{
+					// Sets the size of the font to extract.
+					// Width is dynamically calculated based on the given height.
+					FT_Set_Pixel_Sizes(_face, 0, _size);
+					return true;
+				}
+				FT_Done_Face(_face);
+				_face = nullptr;
+			}
+			_face_failed = true;
+			print_error("Cannot open the font face at '" + _path + "'.");
+			return false;
+		}
+
+		/*!
+		 * Packs a rendered glyph into the atlas pages.
+		 * @param glyph The rendered glyph.
+		 * @return The character with its place in the atlas.
+		 */
+		Character place_glyph(const GlyphBitmap &glyph)
+		{
+			auto character = glyph.character;
+			_cache_dirty = true;
+			if (character.size.x == 0 || character.size.y == 0)
+				return character;
+
+			uint32_t width = character.size.x, height = character.size.y;
+			// One texel of margin keeps the linear filtering from bleeding between glyphs.
+			auto place = allocate(width + 1, height + 1);
+			if (!place)
+			{
+				print_error("Glyph '" + std::to_string(character.codepoint) + "' doesn't fit in a font atlas page.");
+				character.size = {0, 0};
+				return character;
+			}
+			auto[page, x, y] = *place;
+
+			auto &target = _pages[page];
+			for (uint32_t row = 0; row < height; row++)
+				std::copy_n(glyph.pixels.begin() + row * width, width,
+							target.pixels.begin() + (y + row) * IONIC_FONT_PAGE_SIZE + x);
+			target.glyphs.push_back(character.codepoint);
+			target.dirty_begin = maths::min(target.dirty_begin, y);
+			target.dirty_end = maths::max(target.dirty_end, y + height);
+
+			character.position = {x, y};
+			character.page = page;
+			return character;
+		}
+
+		Character rasterize(char32_t codepoint)
+		{
+			if (!open_face())
+			{
+				_cache_dirty = true;
+				return Character{codepoint, {0, 0}, {0, 0}, {0, 0}, 0, 0};
+			}
+			return place_glyph(render_glyph(_face, codepoint, _sdf_spread));
+		}
+
+		bool is_loaded(char32_t codepoint) const
+		{
+			if (codepoint < IONIC_FONT_DIRECT_GLYPHS)
+				return _direct_loaded[codepoint];
+			return _chars.count(codepoint) != 0;
+		}
+
+	public:
+		FontData(std::shared_ptr<FT_LibraryRec_> library, std::string path, uint32_t size, uint32_t sdf_spread = 0)
+				: _library(std::move(library)), _path(std::move(path)), _size(size), _sdf_spread(sdf_spread)
+		{}
+
+		/*!
+		 * Gets the pixel size the glyphs are rasterized at.
+		 * @return The rasterization size.
+		 */
+		uint32_t get_size() const
+		{
+			return _size;
+		}
+
+		/*!
+		 * Gets the margin added around the signed distance field glyphs.
+		 * @return The spread, or 0 if the glyphs are coverage bitmaps.
+		 */
+		uint32_t get_sdf_spread() const
+		{
+			return _sdf_spread;
+		}
+
+		FontData(const FontData &other) = delete;
+
+		~FontData()
+		{
+			save_cache();
+			for (const auto &page : _pages)
+			{
+				if (page.texture == 0)
+					continue;
+				glDeleteTextures(1, &page.texture);
+				glstate::forget_texture(page.texture);
+			}
+			if (_face)
+			{
+				std::lock_guard<std::mutex> lock{face_mutex};
+				FT_Done_Face(_face);
+			}
+		}
+
+		/*!
+		 * Checks whether the font file can be read as a font face.
+		 * @return True if the face is valid, else false.
+		 */
+		bool validate()
+		{
+			return open_face();
+		}
+
+		/*!
+		 * Fills the glyph cache from the cache file matching the font file and size.
+		 * @param cache_directory The directory of the font caches.
+		 * @return True if a valid cache was loaded, else false.
+		 */
+		bool load_cache(const std::string &cache_directory)
+		{
+			auto key = get_font_cache_key(_path, _size, _sdf_spread);
+			if (!key)
+				return false;
+			_cache_key = *key;
+			char name[32];
+			std::snprintf(name, sizeof(name), "%016llx.%s", static_cast<unsigned long long>(_cache_key),
+						  IONIC_FONT_CACHE_EXTENSION);
+			_cache_path = (std::filesystem::path{cache_directory} / name).string();
+
+			MappedFile file{_cache_path};
+			if (!file || file.get_size() < sizeof(FontCacheHeader))
+				return false;
+			FontCacheHeader header;
+			std::memcpy(&header, file.get_data(), sizeof(header));
+			size_t page_bytes = static_cast<size_t>(IONIC_FONT_PAGE_SIZE) * IONIC_FONT_PAGE_SIZE;
+			if (header.magic != IONIC_FONT_CACHE_MAGIC || header.version != IONIC_FONT_CACHE_VERSION ||
+				header.key != _cache_key || header.page_size != IONIC_FONT_PAGE_SIZE ||
+				file.get_size() != sizeof(header) + header.glyph_count * sizeof(FontCacheGlyph) +
+									header.page_count * page_bytes)
+				return false;
+
+			auto glyphs = file.get_data() + sizeof(header);
+			auto pixels = glyphs + header.glyph_count * sizeof(FontCacheGlyph);
+			for (uint32_t page = 0; page < header.page_count; page++)
+			{
+				new_page();
+				std::copy_n(pixels + page * page_bytes, page_bytes, _pages[page].pixels.begin());
+			}
+			for (uint32_t i = 0; i < header.glyph_count; i++)
+			{
+				FontCacheGlyph glyph;
+				std::memcpy(&glyph, glyphs + i * sizeof(FontCacheGlyph), sizeof(glyph));
+				Character character{glyph.codepoint, {glyph.width, glyph.height}, {glyph.x, glyph.y},
+									{glyph.bearing_x, glyph.bearing_y}, glyph.advance, glyph.page};
+				if (glyph.width != 0 && glyph.height != 0)
+				{
+					// Packing the glyphs again in the same order gives the same places and the same skyline.
+					if (glyph.page >= _pages.size())
+						return reset_cache();
+					auto &page = _pages[glyph.page];
+					auto place = page.packer.pack(glyph.width + 1, glyph.height + 1);
+					if (!place || place->first != static_cast<uint32_t>(glyph.x) ||
+						place->second != static_cast<uint32_t>(glyph.y))
+						return reset_cache();
+					page.glyphs.push_back(glyph.codepoint);
+				}
+				set_character(character);
+			}
+			return true;
+		}
+
+		/*!
+		 * Drops a partially loaded cache.
+		 * @return Always false.
+		 */
+		bool reset_cache()
+		{
+			_direct_loaded.reset();
+			_chars.clear();
+			_pages.clear();
+			return false;
+		}
+
+		/*!
+		 * Writes the rasterized glyphs to the cache file if glyphs were added since the cache was loaded.
+		 */
+		void save_cache()
+		{
+			if (!_cache_dirty || _cache_path.empty())
+				return;
+			_cache_dirty = false;
+
+			std::vector<FontCacheGlyph> glyphs;
+			auto add_glyph = [&glyphs](const Character &character)
+			{
+				glyphs.push_back({character.codepoint, character.page, character.size.x, character.size.y,
+								  character.position.x, character.position.y, character.bearing.x,
+								  character.bearing.y, character.advance, 0});
+			};
+			// The glyphs without pixels first, then the glyphs of every page in their packing order.
+			for (uint32_t i = 0; i < _direct_chars.size(); i++)
+				if (_direct_loaded[i] && (_direct_chars[i].size.x == 0 || _direct_chars[i].size.y == 0))
+					add_glyph(_direct_chars[i]);
+			for (const auto &character : _chars)
+				if (character.second.size.x == 0 || character.second.size.y == 0)
+					add_glyph(character.second);
+			for (const auto &page : _pages)
+				for (auto codepoint : page.glyphs)
+					add_glyph(get(codepoint));
+
+			FontCacheHeader header{IONIC_FONT_CACHE_MAGIC, IONIC_FONT_CACHE_VERSION, _cache_key, IONIC_FONT_PAGE_SIZE,
+								   static_cast<uint32_t>(_pages.size()), static_cast<uint32_t>(glyphs.size()), 0};
+
+			// Written next to the destination then renamed, so a concurrent launch never maps a partial file.
+			std::error_code error;
+			std::filesystem::create_directories(std::filesystem::path{_cache_path}.parent_path(), error);
+			auto temporary_path = _cache_path + ".tmp";
+			{
+				std::ofstream output{temporary_path, std::ios::binary | std::ios::trunc};
+				if (!output)
+				{
+					print_error("Cannot write the font cache '" + _cache_path + "'.");
+					return;
+				}
+				output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+				output.write(reinterpret_cast<const char *>(glyphs.data()), glyphs.size() * sizeof(FontCacheGlyph));
+				for (const auto &page : _pages)
+					output.write(reinterpret_cast<const char *>(page.pixels.data()), page.pixels.size());
+				if (!output)
+				{
+					print_error("Cannot write the font cache '" + _cache_path + "'.");
+					return;
+				}
+			}
+			std::filesystem::rename(temporary_path, _cache_path, error);
+			if (error)
+				print_error("Cannot write the font cache '" + _cache_path + "'.");
+		}
+
+		/*!
+		 * Gets a copy of the glyph of a codepoint, rasterizing it if needed.
+		 * The stored glyph may be evicted or replaced by the next call, a reference to it would not stay valid.
+		 */
+		Character get(char32_t codepoint)
+		{
+			std::lock_guard<std::mutex> lock{_mutex};
+			const Character *character;
+			if (codepoint < IONIC_FONT_DIRECT_GLYPHS)
+			{
+				if (!_direct_loaded[codepoint])
+				{
+					_direct_chars[codepoint] = rasterize(codepoint);
+					_direct_loaded[codepoint] = true;
+				}
+				character = &_direct_chars[codepoint];
+			}
+			else
+			{
+				auto it = _chars.find(codepoint);
+				if (it == _chars.end())
+					it = _chars.insert({codepoint, rasterize(codepoint)}).first;
+				character = &it->second;
+			}
+
+			if (character->size.x != 0 && character->size.y != 0)
+				_pages[character->page].last_use = font_frame;
+			return *character;
+		}
+
+		/*!
+		 * Rasterizes the missing glyphs of a codepoint range on the worker pool.
+		 * Every task renders with its own face over the mapped font file, the glyphs are packed afterwards.
+		 */
+		void preload(char32_t first, char32_t last)
+		{
+			std::vector<char32_t> codepoints;
+			{
+				std::lock_guard<std::mutex> lock{_mutex};
+				for (char32_t codepoint = first; codepoint <= last && codepoint >= first; codepoint++)
+					if (!is_loaded(codepoint))
+						codepoints.push_back(codepoint);
+				if (codepoints.empty())
+					return;
+				if (!_file && !_file.open(_path))
+				{
+					print_error("Cannot map the font file '" + _path + "'.");
+					return;
+				}
+			}
+
+			auto &pool = get_worker_pool();
+			// The calling thread renders a part too instead of only waiting.
+			size_t tasks = maths::min(pool.get_thread_count() + 1,
+									  (codepoints.size() + IONIC_FONT_GLYPHS_PER_TASK - 1) / IONIC_FONT_GLYPHS_PER_TASK);
+			size_t per_task = (codepoints.size() + tasks - 1) / tasks;
+			std::vector<std::vector<GlyphBitmap>> glyphs(tasks);
+			auto render = [this, &codepoints, &glyphs, per_task](size_t task)
+			{
+				FT_Face face;
+				{
+					std::lock_guard<std::mutex> lock{face_mutex};
+					if (FT_New_Memory_Face(_library.get(), _file.get_data(), static_cast<FT_Long>(_file.get_size()), 0,
+										   &face))
+						return;
+				}
+				FT_Select_Charmap(face, FT_ENCODING_UNICODE);
+				FT_Set_Pixel_Sizes(face, 0, _size);
+
+				size_t end = maths::min(codepoints.size(), (task + 1) * per_task);
+				for (size_t i = task * per_task; i < end; i++)
+					glyphs[task].push_back(render_glyph(face, codepoints[i], _sdf_spread));
+
+				std::lock_guard<std::mutex> lock{face_mutex};
+				FT_Done_Face(face);
+			};
+
+			std::vector<std::future<void>> futures;
+			for (size_t task = 1; task < tasks; task++)
+				futures.push_back(pool.submit([&render, task]()
+											  {
+												  render(task);
+											  }));
+			render(0);
+			for (auto &future : futures)
+				future.get();
+
+			// Packing stays on the calling thread and in codepoint order, so the atlas layout is deterministic.
+			std::lock_guard<std::mutex> lock{_mutex};
+			for (const auto &task_glyphs : glyphs)
+				for (const auto &glyph : task_glyphs)
+					set_character(place_glyph(glyph));
+		}
+
+		uint32_t get_texture(uint32_t index)
+		{
+			std::lock_guard<std::mutex> lock{_mutex};
+			auto &page = _pages[index];
+			if (page.texture == 0)
+			{
+				// The whole page is uploaded with the texture creation.
+				glGenTextures(1, &page.texture);
+				texture::bind(page.texture);
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, IONIC_FONT_PAGE_SIZE, IONIC_FONT_PAGE_SIZE, 0, GL_RED,
+							 GL_UNSIGNED_BYTE, page.pixels.data());
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				texture::unbind();
+			}
+			else if (page.dirty_begin < page.dirty_end)
+			{
+				// The rows rasterized since the last draw are uploaded at once.
+				texture::bind(page.texture);
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, page.dirty_begin, IONIC_FONT_PAGE_SIZE,
+								page.dirty_end - page.dirty_begin, GL_RED, GL_UNSIGNED_BYTE,
+								page.pixels.data() + static_cast<size_t>(page.dirty_begin) * IONIC_FONT_PAGE_SIZE);
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+				texture::unbind();
+			}
+			page.dirty_begin = IONIC_FONT_PAGE_SIZE;
+			page.dirty_end = 0;
+			return page.texture;
+		}
+	};
+
+	Font::Font(std::shared_ptr<FontData> data, uint32_t size, uint32_t tabSize)
+			: _data(std::move(data)),
 			  _size(size),
 			  _tab_size(tabSize)
-	{}
+	{
+		_scale = static_cast<float>(size) / _data->get_size();
+
+		// The line metrics only depend on the glyphs, they are computed once instead of on every text draw.
+		// The margin of the signed distance fields is not part of the glyph outline.
+		auto spread = static_cast<int32_t>(_data->get_sdf_spread());
+		auto h_char = get_character('H');
+		auto max_bearing_y = h_char.bearing.y - spread;
+		auto g_char = get_character('g');
+		auto below_origin = g_char.size.y - g_char.bearing.y - spread;
+		_max_bearing_y = static_cast<int32_t>(std::lround(max_bearing_y * _scale));
+		_height = static_cast<uint32_t>(std::lround((below_origin + max_bearing_y) * _scale)) + 4;
+	}
 
 	Font::Font(const Font &font) = default;
 
-	Font::Font(Font &&font) noexcept : _texture_id(font._texture_id), _chars(std::move(font._chars)), _size(font._size),
-									   _tab_size(font._tab_size)
-	{}
+	Font::Font(Font &&font) noexcept = default;
+
+	const std::pair<uint32_t, uint32_t> &Font::get_texture_size() const
+	{
+		return _texture_size;
+	}
 
-	uint32_t Font::get_texture_id() const
+	Character Font::get_character(char32_t codepoint) const
 	{
-		return _texture_id;
+		return _data->get(codepoint);
 	}
 
-	const std::pair<uint32_t, uint32_t> &Font::get_texture_size() const
+	uint32_t Font::get_page_texture(uint32_t page) const
 	{
-		return _texture_size;
+		return _data->get_texture(page);
+	}
+
+	void Font::preload(char32_t first, char32_t last) const
+	{
+		_data->preload(first, last);
 	}
 
-	Character Font::get_character(char c) const
+	const FontData *Font::get_data() const
 	{
-		if (!_chars.count(c))
-			return Character{};
-		return _chars.at(c);
+		return _data.get();
+	}
+
+	Font Font::with_size(uint32_t size) const
+	{
+		return {_data, size, _tab_size};
+	}
+
+	bool Font::is_sdf() const
+	{
+		return _data->get_sdf_spread() != 0;
+	}
+
+	float Font::get_scale() const
+	{
+		return _scale;
+	}
+
+	float Font::get_advance(const Character &character) const
+	{
+		// The advance is in 26.6 fixed point, truncating it before the scaling would quantize scaled fonts.
+		return character.advance / 64.f * _scale;
+	}
+
+	int32_t Font::get_max_bearing_y() const
+	{
+		return _max_bearing_y;
 	}
 
 	uint32_t Font::get_size() const
@@ -80,116 +940,117 @@ namespace ionicengine
 
 	uint32_t Font::get_text_length(const std::string &text) const
 	{
-		if (text.empty())
-			return 0;
-		uint32_t length{0};
-		std::string tab;
-		for (uint32_t i = 0; i < get_tab_size(); i++)
-			tab += " ";
-		auto reformatted_text = lambdacommon::lstring::replace_all(text, "\t", tab);
-		for (const auto &line : lambdacommon::lstring::split(reformatted_text, '\n'))
-		{
-			uint32_t x{0};
-			std::string::const_iterator c;
-			for (c = line.begin(); c != line.end(); c++)
-			{
-				x += (get_character(*c).advance >> 6);
-			}
-			if (length < x)
-				length = x;
-		}
-		return length;
+		return text_layout::get(*this, text)->get_width();
 	}
 
 	std::string Font::trim_text_to_length(const std::string &input, uint32_t length, bool reverse) const
 	{
-		std::stringstream ss;
-		uint32_t i = 0;
-		int j = reverse ? static_cast<int>(input.length()) - 1 : 0;
-		int increment = reverse ? -1 : 1;
-
-		for (int l = j; l >= 0 && l < input.length() && i < length; l += increment)
+		float i = 0.f;
+		if (reverse)
 		{
-			char current_char = input.at(l);
-			uint32_t width = get_character(current_char).advance >> 6;
-
-			i += width;
-
-			if (reverse)
+			// Walks back codepoint by codepoint and keeps the tail of the input.
+			size_t start = input.size();
+			while (start > 0 && i < length)
 			{
-				const std::string &temp = ss.str();
-				ss.seekp(0);
-				ss << current_char;
-				ss << temp;
+				size_t previous = utf8::previous(input, start);
+				size_t offset = previous;
+				i += get_advance(get_character(utf8::decode(input, offset)));
+				start = previous;
 			}
-			else
-				ss << current_char;
+			return input.substr(start);
 		}
 
-		return ss.str();
+		size_t end = 0;
+		while (end < input.size() && i < length)
+			i += get_advance(get_character(utf8::decode(input, end)));
+		return input.substr(0, end);
 	}
 
 	std::string Font::trim_text_to_length_dotted(const std::string &input, uint32_t length) const
 	{
 		auto trimmed_text = trim_text_to_length(input, length);
 		if (trimmed_text != input)
-			trimmed_text = trimmed_text.substr(0, trimmed_text.length() - 3) + "...";
+		{
+			// Removes the three last codepoints without splitting a multi-byte sequence.
+			size_t end = trimmed_text.size();
+			for (int removed = 0; removed < 3 && end > 0; removed++)
+				end = utf8::previous(trimmed_text, end);
+			trimmed_text = trimmed_text.substr(0, end) + "...";
+		}
 
 		return trimmed_text;
 	}
 
 	uint32_t Font::get_text_height(const std::string &text) const
 	{
-		return static_cast<uint32_t>(lambdacommon::lstring::split(text, '\n').size() * get_height());
+		return text_layout::get(*this, text)->get_height();
 	}
 
 	uint32_t Font::get_height() const
 	{
-		auto h_char = get_character('H');
-		auto g_char = get_character('g');
-		auto below_origin = static_cast<uint32_t>(g_char.size.y - g_char.bearing.y);
-		auto max_bearing_y = h_char.bearing.y;
-		return below_origin + max_bearing_y + 4;
+		return _height;
 	}
 
 	bool Font::operator==(const Font &font) const
 	{
-		return _chars == font._chars &&
+		// The glyphs of a font are identified by the face they are rasterized from.
+		return _data == font._data &&
 			   _size == font._size &&
 			   _tab_size == font._tab_size;
 	}
 
 	bool Font::operator<(const Font &font) const
 	{
-		return std::tie(_chars, _size, _tab_size) < std::tie(font._chars, font._size, font._tab_size);
+		return std::tie(_data, _size, _tab_size) < std::tie(font._data, font._size, font._tab_size);
 	}
 
-	std::map<lambdacommon::ResourceName, Font *> fonts;
+	ResourceStorage<Font *> fonts;
 
 	FontManager::FontManager()
 	{
+		FT_Library ft;
 		if (FT_Init_FreeType(&ft))
 			throw std::runtime_error("Cannot initialize FreeType library!");
+		// The library is released once the manager and every loaded face are gone.
+		_library = std::shared_ptr<FT_LibraryRec_>(ft, FT_Done_FreeType);
 
 #ifdef LAMBDA_WINDOWS
 		default_font = {"windows:fonts/arial"};
 		if (!this->load_font(default_font, std::string("C:\\Windows\\Fonts\\arial.ttf"), 12))
 			throw std::runtime_error("Cannot load arial.ttf");
 #else
-		if (!this->loadFont(default_font, std::string("LiberationSans-Regular.ttf"), 12))
+		if (!this->load_font(default_font, std::string("LiberationSans-Regular.ttf"), 12))
 			throw std::runtime_error("Cannot load LiberationSans-Regular.ttf");
 #endif
+		default_font_handle = resource::intern(default_font);
+	}
+
+	FontManager::~FontManager() = default;
+
+	void FontManager::shutdown()
+	{
+		// The cached layouts hold copies of the fonts.
+		text_layout::clear_cache();
+		fonts.for_each([](ResourceHandle, Font *font)
+					   {
+						   delete font;
+					   });
+		fonts.clear();
 	}
 
-	FontManager::~FontManager()
+	void FontManager::new_frame()
 	{
-		FT_Done_FreeType(ft);
+		font_frame++;
 	}
 
-	void FontManager::shutdown()
+	const std::string &FontManager::get_cache_directory() const
 	{
-		for (auto font : fonts)
-			delete font.second;
+		return _cache_directory;
+	}
+
+	void FontManager::set_cache_directory(const std::string &directory)
+	{
+		_cache_directory = directory;
 	}
 
 	lambdacommon::ResourceName FontManager::get_default_font_name() const
@@ -199,147 +1060,53 @@ namespace ionicengine
 
 	Font *FontManager::get_default_font() const
 	{
-		return get_font(default_font);
+		return get_font(default_font_handle);
 	}
 
 	Font *FontManager::get_font(const lambdacommon::ResourceName &font_name) const
 	{
-		return fonts.at(font_name);
+		return fonts.at(resource::find(font_name));
 	}
 
-	std::optional<Font> FontManager::load_font(const lambdacommon::ResourceName &font_name, uint32_t size) const
+	Font *FontManager::get_font(ResourceHandle font) const
+	{
+		return fonts.at(font);
+	}
+
+	std::optional<Font>
+	FontManager::load_font(const lambdacommon::ResourceName &font_name, uint32_t size, FontMode mode) const
 	{
 		if (!get_resources_manager().does_resource_exist(font_name, "ttf"))
 			return std::nullopt;
-		return load_font(font_name, get_resources_manager().get_resource_path(font_name, "ttf"), size);
+		return load_font(font_name, get_resources_manager().get_resource_path(font_name, "ttf"), size, mode);
 	}
 
 	std::optional<Font>
 	FontManager::load_font(const lambdacommon::ResourceName &font_name, const lambdacommon::fs::FilePath &path,
-						   uint32_t size) const
+						   uint32_t size, FontMode mode) const
 	{
-		return load_font(font_name, path.to_string(), size);
+		return load_font(font_name, path.to_string(), size, mode);
 	}
 
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-
-#include <stb_image_write.h>
-
 	std::optional<Font>
-	FontManager::load_font(const lambdacommon::ResourceName &font_name, const std::string &path, uint32_t size) const
+	FontManager::load_font(const lambdacommon::ResourceName &font_name, const std::string &path, uint32_t size,
+						   FontMode mode) const
 	{
-		FT_Face face;
-		if (FT_New_Face(ft, path.c_str(), 0, &face))
+		IONIC_PROFILE_SCOPE("FontManager::load_font");
+		IONIC_TRACE_SCOPE("FontManager::load_font");
+		// A signed distance field font is rasterized once at a fixed size and drawn at any size.
+		auto data = mode == FONT_SDF
+					? std::make_shared<FontData>(_library, path, IONIC_FONT_SDF_SIZE, IONIC_FONT_SDF_SPREAD)
+					: std::make_shared<FontData>(_library, path, size);
+		// With a valid cache the glyphs come from the cache file, FreeType only opens the face on a missing glyph.
+		bool cached = !_cache_directory.empty() && data->load_cache(_cache_directory);
+		if (!cached && !data->validate())
 			return std::nullopt;
 
-		if (FT_Select_Charmap(face, FT_ENCODING_UNICODE))
-			return std::nullopt;
-
-		//auto hb_ft_font = hb_ft_font_create(face, nullptr);
-
-		// Sets the size of the font to extract.
-		// Width is dynamically calculated based on the given height.
-		FT_Set_Pixel_Sizes(face, 0, size);
-
-		std::map<char, Character> characters_map;
-
-		// Disable byte-alignment restriction
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-		FT_GlyphSlot g = face->glyph;
-		uint32_t w = 0;
-		uint32_t h = 0;
-
-		for (uint32_t c = 0; c < IONIC_MAX_GLYPHS; c++)
-		{
-			if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-				continue;
-
-			w += face->glyph->bitmap.width;
-			h = maths::max(h, face->glyph->bitmap.rows);
-		}
-
-		uint32_t texture_atlas;
-		glGenTextures(1, &texture_atlas);
-		texture::bind(texture_atlas);
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, w, h, 0, GL_ALPHA, GL_UNSIGNED_BYTE, nullptr);
-		// Set texture options.
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		uint32_t x = 0;
-
-		for (uint32_t c = 0; c < IONIC_MAX_GLYPHS; c++)
-		{
-			if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-			{
-				print_error("Failed to load Glyph '" + std::to_string(c) + "'.");
-				continue;
-			}
-
-			texture::bind(texture_atlas);
-			glTexSubImage2D(GL_TEXTURE_2D, 0, x, 0, g->bitmap.width, g->bitmap.rows, GL_ALPHA, GL_UNSIGNED_BYTE,
-							g->bitmap.buffer);
-
-			// Generate texture.
-			uint32_t texture;
-			glGenTextures(1, &texture);
-			texture::bind(texture);
-			glTexImage2D(
-					GL_TEXTURE_2D,
-					0,
-					GL_RED,
-					face->glyph->bitmap.width,
-					face->glyph->bitmap.rows,
-					0,
-					GL_RED,
-					GL_UNSIGNED_BYTE,
-					face->glyph->bitmap.buffer
-			);
-			// Set texture options.
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			// Now store character for later use.
-			Character character{
-					c,
-					texture,
-					{g->bitmap.width, g->bitmap.rows},
-					{g->bitmap_left, g->bitmap_top},
-					glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-					static_cast<uint32_t>(face->glyph->advance.x)
-			};
-			characters_map.insert(std::pair<char, Character>(c, character));
-
-			x += g->bitmap.width;
-		}
-
-		auto *pixels = (unsigned char *) malloc(w * h);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels);
-
-		unsigned char *png_data = (unsigned char *) calloc(w * h * 4, 1);
-		for (int i = 0; i < (w * h); ++i)
-		{
-			png_data[i * 4 + 0] |= 0;
-			png_data[i * 4 + 1] |= 0;
-			png_data[i * 4 + 2] |= 0;
-			png_data[i * 4 + 3] = pixels[i];
-		}
-
-		stbi_write_png("font_output.png", w, h, 4, png_data, w * 4);
-
-		texture::unbind();
-		//hb_font_destroy(hb_ft_font);
-		FT_Done_Face(face);
-
-		Font *font = new Font{texture_atlas, {w, h}, characters_map, size};
-		print_debug("[IonicEngine] Font '" + font_name.to_string() + "' at '" + path + "' loaded successfully!");
-		fonts[font_name] = font;
+		Font *font = new Font{data, size};
+		print_debug("[IonicEngine] Font '" + font_name.to_string() + "' at '" + path + "' loaded successfully" +
+					(cached ? " from the cache!" : "!"));
+		fonts.set(resource::intern(font_name), font);
 		return {*font};
 	}
 }
\ No newline at end of file
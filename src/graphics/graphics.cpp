@@ -8,24 +8,31 @@
  */
 
 #include "../../include/ionicengine/graphics/graphics.h"
+#include "../../include/ionicengine/graphics/batch.h"
 #include "../../include/ionicengine/gl/buffer.h"
+#include "../../include/ionicengine/gl/state.h"
+#include "../../include/ionicengine/profiler.h"
+#include <cmath>
 #include <utility>
 
 using namespace lambdacommon;
 
-#define ENABLE_OPENGL_OPTIONS glEnable(GL_CULL_FACE); \
-                                glEnable(GL_BLEND); \
-                                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-#define DISABLE_OPENGL_OPTIONS glDisable(GL_CULL_FACE); \
-                                glDisable(GL_BLEND);
-
 #define toFloat(i) static_cast<float>(i)
 #define clampX(i) toFloat(lambdacommon::maths::clamp(i, 0.f, static_cast<float>(get_width())))
 #define clampY(i) toFloat(lambdacommon::maths::clamp(i, 0.f, static_cast<float>(get_height())))
 
 namespace ionicengine
 {
+	RenderStats &RenderStats::operator+=(const RenderStats &other)
+	{
+		draw_calls += other.draw_calls;
+		program_switches += other.program_switches;
+		texture_binds += other.texture_binds;
+		buffer_uploads += other.buffer_uploads;
+		vertices += other.vertices;
+		return *this;
+	}
+
 	Graphics::Graphics(const Dimension2D_u32 &framebufferSize)
 			: _framebuffer_size(framebufferSize), _projection2d(
 			glm::ortho(0.0f, static_cast<float>(framebufferSize.get_width()),
@@ -67,15 +74,87 @@ namespace ionicengine
 
 	void Graphics::update_framebuffer_size(uint32_t width, uint32_t height)
 	{
+		// Pending draws were made with the old projection.
+		flush();
 		_framebuffer_size = {width, height};
 		_projection2d = glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f);
 	}
 
+	bool Graphics::is_batching() const
+	{
+		return _batching;
+	}
+
+	void Graphics::set_batching(bool batching)
+	{
+		if (!batching)
+			flush();
+		_batching = batching;
+	}
+
+	uint8_t Graphics::get_layer() const
+	{
+		return _layer;
+	}
+
+	void Graphics::set_layer(uint8_t layer)
+	{
+		_layer = layer;
+	}
+
+	BlendMode Graphics::get_blend_mode() const
+	{
+		return _blend_mode;
+	}
+
+	void Graphics::set_blend_mode(BlendMode blend_mode)
+	{
+		if (blend_mode == _blend_mode)
+			return;
+		flush();
+		_blend_mode = blend_mode;
+	}
+
+	const RenderStats &Graphics::get_frame_stats() const
+	{
+		return _frame_stats;
+	}
+
+	const RenderStats &Graphics::get_total_stats() const
+	{
+		return _total_stats;
+	}
+
+	void Graphics::end_frame_stats()
+	{
+		_frame_stats = _stats;
+		_total_stats += _stats;
+		_stats = {};
+	}
+
+	void Graphics::reset_total_stats()
+	{
+		_total_stats = {};
+	}
+
+	void Graphics::flush()
+	{}
+
 	void Graphics::reset_transform()
 	{
 		_transform = glm::mat4{1.0f};
 	}
 
+	const glm::mat4 &Graphics::get_transform() const
+	{
+		return _transform;
+	}
+
+	void Graphics::set_transform(const glm::mat4 &transform)
+	{
+		_transform = transform;
+	}
+
 	void Graphics::translate(int x, int y, int z)
 	{
 		translate(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
@@ -147,9 +226,23 @@ namespace ionicengine
 	void Graphics::draw_image(const lambdacommon::ResourceName &texture, float x, float y, float width, float height,
 							  const TextureRegion &region)
 	{
-		if (!texture::has_texture(texture))
+		draw_image(resource::find(texture), x, y, width, height, region);
+	}
+
+	void Graphics::draw_image(ResourceHandle texture, int x, int y, uint32_t width, uint32_t height,
+							  const TextureRegion &region)
+	{
+		draw_image(texture, static_cast<float>(x), static_cast<float>(y), static_cast<float>(width),
+				   static_cast<float>(height), region);
+	}
+
+	void Graphics::draw_image(ResourceHandle texture, float x, float y, float width, float height,
+							  const TextureRegion &region)
+	{
+		auto stored_texture = texture::find_texture(texture);
+		if (stored_texture == nullptr)
 			return;
-		draw_image(texture::get_texture(texture), x, y, width, height, region);
+		draw_image(*stored_texture, x, y, width, height, region);
 	}
 
 	void Graphics::draw_image(const Texture &texture, int x, int y, uint32_t width, uint32_t height,
@@ -159,242 +252,489 @@ namespace ionicengine
 				   static_cast<float>(height), region);
 	}
 
+	void Graphics::draw_image_instanced(const Texture &texture, const std::vector<SpriteInstance> &instances)
+	{
+		draw_image_instanced(texture, instances.data(), instances.size());
+	}
+
+	void Graphics::draw_text(const Font &font, int x, int y, const std::string &text, uint32_t maxWidth,
+							 uint32_t maxHeight, float scale)
+	{
+		auto wrap_width = maxWidth == 0 ? 0 : static_cast<uint32_t>(maxWidth / scale);
+		draw_text(*text_layout::get(font, text, wrap_width), x, y, maxHeight, scale);
+	}
+
 	class GraphicsGL3 : public Graphics
 	{
-	private:
-		uint32_t vao, vbo;
-	public:
-		explicit GraphicsGL3(const Dimension2D_u32 &framebuffer_size, uint32_t vao, uint32_t vbo)
-				: Graphics(framebuffer_size), vao(vao), vbo(vbo)
+	protected:
+		SpriteBatch sprite_batch;
+		PrimitiveBatch primitive_batch;
+		SpriteInstancer sprite_instancer;
+		// Resolved once, the draw paths never look up shaders by name.
+		Shader sprite_shader, sprite_instanced_shader, text_shader, text_sdf_shader, primitive_shader;
+
+		static Shader resolve_shader(const lambdacommon::ResourceName &shader_name)
 		{
+			if (!shader::hasShader(shader_name))
+				return {};
+			return shader::getShader(shader_name);
 		}
 
-		void set_color(const lambdacommon::Color &color) override
+	public:
+		using Graphics::draw_image_instanced;
+		using Graphics::draw_text;
+
+		explicit GraphicsGL3(const Dimension2D_u32 &framebuffer_size) : Graphics(framebuffer_size),
+																		sprite_instancer(texture_vbo),
+																		sprite_shader(resolve_shader(IONICENGINE_SHADERS_SPRITE)),
+																		sprite_instanced_shader(resolve_shader(
+																				IONICENGINE_SHADERS_SPRITE_INSTANCED)),
+																		text_shader(resolve_shader(SHADER_TEXT)),
+																		text_sdf_shader(resolve_shader(SHADER_TEXT_SDF)),
+																		primitive_shader(resolve_shader(IONICENGINE_SHADERS_PRIMITIVE))
 		{
-			this->color = color;
 		}
 
-		void draw_line_2d(float x, float y, float x2, float y2) override
+		~GraphicsGL3() override
 		{
-			if (!shader::hasShader(IONICENGINE_SHADERS_2DBASIC))
-				return;
-
-			// Set OpenGL options.
-			ENABLE_OPENGL_OPTIONS;
+			flush();
+		}
 
-			glm::mat4 model{1.f};
+		/*!
+		 * Transforms a point with the current transformation and creates a colored vertex from it.
+		 */
+		ColoredVertex colored_vertex(float x, float y) const
+		{
+			auto position = _transform * glm::vec4{x, y, 0.f, 1.f};
+			return {position.x, position.y, color.red(), color.green(), color.blue(), color.alpha()};
+		}
 
-			GLfloat vertices[2][4] = {
-					{clampX(x),  clampY(y),  0.f, 0.f},
-					{clampX(x2), clampY(y2), 0.f, 0.f}
-			};
+		/*!
+		 * Writes the two triangles of a transformed rectangle.
+		 * @param vertices The six vertices to write.
+		 */
+		void rectangle_triangles(float x, float y, float width, float height, ColoredVertex *vertices) const
+		{
+			auto top_left = colored_vertex(x, y), top_right = colored_vertex(x + width, y),
+					bottom_left = colored_vertex(x, y + height), bottom_right = colored_vertex(x + width, y + height);
+			vertices[0] = top_left;
+			vertices[1] = bottom_left;
+			vertices[2] = top_right;
+			vertices[3] = top_right;
+			vertices[4] = bottom_left;
+			vertices[5] = bottom_right;
+		}
 
-			// Shader
-			auto shader = shader::getShader(IONICENGINE_SHADERS_2DBASIC);
-			shader.use();
-			shader.set_matrix_4f("projection", _projection2d);
-			shader.set_matrix_4f("model", model);
-			shader.set_matrix_4f("transform", _transform);
-			shader.set_color(color);
+		/*!
+		 * Adds a transformed quad to the sprite batch, submitting the pending draws first if they cannot be merged.
+		 * @param shader The shader of the quad.
+		 * @param texture_id The OpenGL texture ID of the quad.
+		 * @param quad The four vertices of the quad.
+		 */
+		virtual void emit_sprite(const Shader &shader, uint32_t texture_id, const SpriteVertex quad[4])
+		{
+			if (!primitive_batch.is_empty() || sprite_batch.needs_flush(shader, texture_id))
+				submit();
+			sprite_batch.push(shader, texture_id, quad);
+		}
 
-			vao::bind(this->vao);
+		/*!
+		 * Adds transformed primitives to the primitive batch, submitting the pending draws first if needed.
+		 * @param vertices The vertices.
+		 * @param count The amount of vertices.
+		 * @param triangles True if the vertices are triangles, false if they are lines.
+		 */
+		virtual void emit_primitives(const ColoredVertex *vertices, size_t count, bool triangles)
+		{
+			// Triangles are drawn before lines, triangles coming after lines would end up below them.
+			if (!sprite_batch.is_empty() || !primitive_batch.can_fit(count) || (triangles && primitive_batch.has_lines()))
+				submit();
+			if (triangles)
+				primitive_batch.push_triangles(vertices, count);
+			else
+				primitive_batch.push_lines(vertices, count);
+		}
 
-			// Update content of VBO memory.
-			vbo::bind(this->vbo);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
+		/*!
+		 * Draws sprite instances after the pending draws.
+		 * @param texture_id The OpenGL texture ID of the instances.
+		 * @param projection The projection including the transformation of the instances.
+		 * @param tint The color multiplied with the color of every instance.
+		 * @param instances The instances.
+		 * @param count The number of instances.
+		 */
+		virtual void emit_instances(uint32_t texture_id, const glm::mat4 &projection, const lambdacommon::Color &tint,
+									const SpriteInstance *instances, size_t count)
+		{
+			submit();
+			IONIC_PROFILE_GPU_SCOPE("Graphics::submit_instances");
+			apply_blend_state();
+			auto state_counters = glstate::get_counters();
+			if (sprite_instancer.draw(sprite_instanced_shader, texture_id, projection, tint, instances, count))
+			{
+				_stats.draw_calls++;
+				_stats.buffer_uploads++;
+				_stats.vertices += count * 4;
+			}
+			count_state_changes(state_counters);
+		}
 
-			vbo::bind(0);
-			// Render quad.
-			glDrawArrays(GL_LINES, 0, 2);
+		/*!
+		 * Transforms a textured quad with the current transformation and adds it to the sprite batch.
+		 */
+		void push_sprite(const Shader &shader, uint32_t texture_id, float x, float y, float width, float height,
+						 const TextureRegion &region)
+		{
+			// Transform the corners on the CPU, the whole batch shares the same projection only.
+			const float corners[4][2] = {{0.f, 0.f}, {1.f, 0.f}, {0.f, 1.f}, {1.f, 1.f}};
+			SpriteVertex quad[4];
+			for (size_t i = 0; i < 4; i++)
+			{
+				auto position = _transform * glm::vec4{x + corners[i][0] * width, y + corners[i][1] * height, 0.f, 1.f};
+				quad[i] = {position.x, position.y,
+						   corners[i][0] == 0.f ? region.min_x() : region.max_x(),
+						   corners[i][1] == 0.f ? region.min_y() : region.max_y(),
+						   color.red(), color.green(), color.blue(), color.alpha()};
+			}
+			emit_sprite(shader, texture_id, quad);
+		}
 
-			vao::unbind();
+		/*!
+		 * Sets the OpenGL options shared by every 2D draw.
+		 * They are kept between the submits of a flush and only reach the driver when they changed.
+		 */
+		void apply_blend_state()
+		{
+			glstate::enable(GL_CULL_FACE);
+			glstate::enable(GL_BLEND);
+			// The alpha channel accumulates the coverage, which makes render targets hold premultiplied colors.
+			if (_blend_mode == BLEND_PREMULTIPLIED)
+				glstate::blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+			else
+				glstate::blend_func_separate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		}
 
-			// Unset OpenGL options.
-			DISABLE_OPENGL_OPTIONS;
+		/*!
+		 * Adds the program switches and texture binds which reached the driver since the specified counters to the
+		 * statistics of the frame.
+		 */
+		void count_state_changes(const GLStateCounters &before)
+		{
+			const auto &after = glstate::get_counters();
+			_stats.program_switches += after.program_switches - before.program_switches;
+			_stats.texture_binds += after.texture_binds - before.texture_binds;
 		}
 
-		void draw_quad(float x, float y, float width, float height) override
+		/*!
+		 * Draws the content of the batches.
+		 */
+		void submit()
 		{
-			if (!shader::hasShader(IONICENGINE_SHADERS_2DBASIC))
+			if (sprite_batch.is_empty() && primitive_batch.is_empty())
 				return;
 
-			// Set OpenGL options.
-			ENABLE_OPENGL_OPTIONS;
-
-			glm::mat4 model{1.f};
-			model = glm::translate(model, {x, y, 0.f});
-			model = glm::scale(model, {width, height, 1.f});
+			IONIC_PROFILE_GPU_SCOPE("Graphics::submit");
+			apply_blend_state();
+			auto state_counters = glstate::get_counters();
 
-			// Shader
-			auto shader = shader::getShader(IONICENGINE_SHADERS_2DBASIC);
-			shader.use();
-			shader.set_matrix_4f("projection", _projection2d);
-			shader.set_matrix_4f("model", model);
-			shader.set_matrix_4f("transform", _transform);
-			shader.set_color(color);
+			// Only one of the batches holds draws at a time, which keeps the painter's order.
+			auto sprites = sprite_batch.get_pending_sprites();
+			if (sprite_batch.flush(_projection2d))
+			{
+				_stats.draw_calls++;
+				_stats.buffer_uploads++;
+				_stats.vertices += sprites * 4;
+			}
+			if (!primitive_batch.is_empty() && primitive_shader)
+			{
+				auto vertices = primitive_batch.get_pending_vertices();
+				_stats.draw_calls += primitive_batch.flush(primitive_shader, _projection2d);
+				_stats.buffer_uploads++;
+				_stats.vertices += vertices;
+			}
+			count_state_changes(state_counters);
+		}
 
-			vao::bind(quad_vao);
-			// Render quad.
-			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-			vao::unbind();
+		void flush() override
+		{
+			submit();
+			// Raw OpenGL calls made after a flush find blending and culling off, as they were before the 2D draws.
+			glstate::disable(GL_BLEND);
+			glstate::disable(GL_CULL_FACE);
+		}
 
-			// Unset OpenGL options.
-			DISABLE_OPENGL_OPTIONS;
+		void set_color(const lambdacommon::Color &color) override
+		{
+			this->color = color;
 		}
 
-		void draw_quad_outline(float x, float y, float width, float height) override
+		void draw_line_2d(float x, float y, float x2, float y2) override
 		{
-			if (!shader::hasShader(IONICENGINE_SHADERS_2DBASIC))
+			IONIC_PROFILE_SCOPE("Graphics::draw_line");
+			x = clampX(x), y = clampY(y), x2 = clampX(x2), y2 = clampY(y2);
+			float length = std::sqrt((x2 - x) * (x2 - x) + (y2 - y) * (y2 - y));
+			if (length == 0.f)
 				return;
+			// Lines are one pixel wide quads, so they share the triangle stream of the quads drawn around them.
+			// Wound counter-clockwise like {@code rectangle_triangles}, else the culling drops them.
+			float normal_x = (y - y2) / length * 0.5f, normal_y = (x2 - x) / length * 0.5f;
+			auto start_left = colored_vertex(x + normal_x, y + normal_y),
+					start_right = colored_vertex(x - normal_x, y - normal_y),
+					end_left = colored_vertex(x2 + normal_x, y2 + normal_y),
+					end_right = colored_vertex(x2 - normal_x, y2 - normal_y);
+			ColoredVertex vertices[6] = {start_left, end_left, start_right, start_right, end_left, end_right};
+			emit_primitives(vertices, 6, true);
+
+			if (!_batching)
+				flush();
+		}
 
-			// Set OpenGL options.
-			ENABLE_OPENGL_OPTIONS;
-
-			glm::mat4 model{1.f};
-			model = glm::translate(model, {x, y, 0.f});
-			model = glm::scale(model, {width, height, 1.f});
-
-			// Shader
-			auto shader = shader::getShader(IONICENGINE_SHADERS_2DBASIC);
-			shader.use();
-			shader.set_matrix_4f("projection", _projection2d);
-			shader.set_matrix_4f("model", model);
-			shader.set_matrix_4f("transform", _transform);
-			shader.set_color(color);
+		void draw_quad(float x, float y, float width, float height) override
+		{
+			IONIC_PROFILE_SCOPE("Graphics::draw_quad");
+			ColoredVertex vertices[6];
+			rectangle_triangles(x, y, width, height, vertices);
+			emit_primitives(vertices, 6, true);
 
-			vao::bind(quad_outline_vao);
-			// Render quad.
-			glDrawArrays(GL_LINE_LOOP, 0, 4);
-			vao::unbind();
+			if (!_batching)
+				flush();
+		}
 
-			// Unset OpenGL options.
-			DISABLE_OPENGL_OPTIONS;
+		void draw_quad_outline(float x, float y, float width, float height) override
+		{
+			IONIC_PROFILE_SCOPE("Graphics::draw_quad_outline");
+			// The edges are one pixel wide rectangles inside the quad, a widget outlined after its fill and before the
+			// next widget stays in the same triangle stream.
+			float thickness_x = maths::min(1.f, width), thickness_y = maths::min(1.f, height);
+			float side_height = maths::max(0.f, height - 2.f * thickness_y);
+			ColoredVertex vertices[24];
+			rectangle_triangles(x, y, width, thickness_y, vertices);
+			rectangle_triangles(x, y + height - thickness_y, width, thickness_y, vertices + 6);
+			rectangle_triangles(x, y + thickness_y, thickness_x, side_height, vertices + 12);
+			rectangle_triangles(x + width - thickness_x, y + thickness_y, thickness_x, side_height, vertices + 18);
+			emit_primitives(vertices, 24, true);
+
+			if (!_batching)
+				flush();
 		}
 
 		void draw_image(const Texture &texture, float x, float y, float width, float height,
 						const TextureRegion &region) override
 		{
+			IONIC_PROFILE_SCOPE("Graphics::draw_image");
 			if (!texture)
 				return;
-			if (!shader::hasShader(IONICENGINE_SHADERS_IMAGE))
+			if (!sprite_shader)
 				return;
 
-			// Set OpenGL options.
-			ENABLE_OPENGL_OPTIONS;
-
-			glm::mat4 model{1.f};
-			model = glm::translate(model, {x, y, 0.f});
-			model = glm::scale(model, {width, height, 1.f});
-
-			GLfloat texCoords[4][2] = {
-					{region.min_x(), region.max_y()},
-					{region.max_x(), region.max_y()},
-					{region.min_x(), region.min_y()},
-					{region.max_x(), region.min_y()}
-			};
-
-			// Shader
-			auto shader = shader::getShader(IONICENGINE_SHADERS_IMAGE);
-			shader.use();
-			shader.set_matrix_4f("projection", _projection2d);
-			shader.set_matrix_4f("model", model);
-			shader.set_matrix_4f("transform", _transform);
-			for (size_t i = 0; i < 4; i++)
-			{
-				shader.set_vector_2f("texCoordsData[" + std::to_string(i) + "]", texCoords[i][0], texCoords[i][1]);
-			}
-			shader.set_integer("image", 0);
-			shader.set_color(color);
+			push_sprite(sprite_shader, texture.get_id(), x, y, width, height, region);
 
-			texture.bind();
+			if (!_batching)
+				flush();
+		}
 
-			vao::bind(texture_vao);
-			// Render quad.
-			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-			vao::unbind();
+		void draw_image_instanced(const Texture &texture, const SpriteInstance *instances, size_t count) override
+		{
+			IONIC_PROFILE_SCOPE("Graphics::draw_image_instanced");
+			if (count == 0 || !sprite_instanced_shader)
+				return;
 
-			texture.unbind();
+			// The instances are placed on the GPU, the transformation goes with the projection.
+			emit_instances(texture.get_id(), _projection2d * _transform, color, instances, count);
 
-			// Unset OpenGL options.
-			DISABLE_OPENGL_OPTIONS;
+			if (!_batching)
+				flush();
 		}
 
-		void
-		draw_text(const Font &font, int xPos, int yPos, const std::string &text, uint32_t maxWidth, uint32_t maxHeight,
-				  float scale) override
+		void draw_text(const TextLayout &layout, int x, int y, uint32_t maxHeight, float scale) override
 		{
-			if (!shader::hasShader(SHADER_TEXT))
+			IONIC_PROFILE_SCOPE("Graphics::draw_text");
+			const auto &font = layout.get_font();
+			// Every glyph is a quad sampled from a font atlas page, a string is one batch per page it uses.
+			const auto &shader = font.is_sdf() ? text_sdf_shader : text_shader;
+			if (!shader)
 				return;
-			// Set OpenGL options
-			ENABLE_OPENGL_OPTIONS;
-
-			// Shader
-			auto shader = shader::getShader(SHADER_TEXT);
-			shader.use();
-			shader.set_matrix_4f("projection", _projection2d);
-			shader.set_matrix_4f("transform", _transform);
-			shader.set_integer("text", 0);
-			shader.set_color(color);
-			glActiveTexture(GL_TEXTURE0);
-			vao::bind(this->vao);
-
-			glm::mat4 model{1.f};
-
-			auto x = static_cast<float>(xPos);
-			auto y = static_cast<float>(yPos);
-			float original_x = x;
-			float original_y = y;
-
-			// Iterate through all characters.
-			std::string::const_iterator c;
-			for (c = text.begin(); c != text.end(); c++)
-			{
-				Character ch = font.get_character(*c);
 
-				if (maxWidth != 0.f && x + (ch.advance >> 6) >= (original_x + maxWidth))
-				{
-					x = original_x;
-					y += font.get_height() * scale;
-				}
-				if (maxHeight != 0.f && (y + font.get_height() / 2.f) > (original_y + maxHeight))
+			auto atlas_width = static_cast<float>(font.get_texture_size().first);
+			auto atlas_height = static_cast<float>(font.get_texture_size().second);
+			auto max_bearing_y = font.get_max_bearing_y() * scale;
+			auto line_height = static_cast<float>(font.get_height());
+			// The character metrics are in rasterization pixels.
+			auto glyph_scale = scale * font.get_scale();
+			auto origin_x = static_cast<float>(x);
+			auto origin_y = static_cast<float>(y);
+
+			const auto &glyphs = layout.get_glyphs();
+			for (const auto &line : layout.get_lines())
+			{
+				if (line.glyph_count == 0)
+					continue;
+				auto line_y = glyphs[line.first_glyph].y;
+				if (maxHeight != 0 && (line_y + line_height / 2.f) * scale > maxHeight)
 					break;
 
-				// Special characters handling.
-				if (*c == '\t')
+				for (size_t i = line.first_glyph; i < line.first_glyph + line.glyph_count; i++)
 				{
-					for (uint32_t i = 0; i < font.get_tab_size(); i++)
-						x += (ch.advance >> 6) * scale;
-					continue;
-				}
-				else if (*c == '\n')
-				{
-					x = original_x;
-					y += font.get_height() * scale;
-					continue;
+					const auto &glyph = glyphs[i];
+					Character ch = font.get_character(glyph.codepoint);
+					if (ch.size.x == 0 || ch.size.y == 0)
+						continue;
+
+					GLfloat xpos = origin_x + glyph.x * scale + ch.bearing.x * glyph_scale;
+					GLfloat ypos = origin_y + glyph.y * scale + max_bearing_y - ch.bearing.y * glyph_scale;
+					GLfloat w = ch.size.x * glyph_scale;
+					GLfloat h = ch.size.y * glyph_scale;
+					push_sprite(shader, font.get_page_texture(ch.page), xpos, ypos, w, h,
+								{ch.position.x / atlas_width, ch.position.y / atlas_height,
+								 (ch.position.x + ch.size.x) / atlas_width, (ch.position.y + ch.size.y) / atlas_height});
 				}
+			}
+
+			if (!_batching)
+				flush();
+		}
+	};
+
+	/*!
+	 * OpenGL 3.3 graphics recording the draws of a frame and submitting them on flush,
+	 * sorted by layer, overlap depth and render state so that draws which do not overlap share batches.
+	 */
+	class GraphicsGL3Sorted : public GraphicsGL3
+	{
+	private:
+		struct RecordedSprite
+		{
+			uint32_t shader;
+			uint32_t texture;
+			SpriteVertex quad[4];
+		};
+
+		struct RecordedInstances
+		{
+			uint32_t texture;
+			glm::mat4 projection;
+			lambdacommon::Color tint;
+			size_t first;
+		};
+
+		CommandQueue _queue;
+		// The shaders used by the recorded sprites, few in a frame.
+		std::vector<Shader> _shaders;
+		std::vector<RecordedSprite> _sprites;
+		std::vector<ColoredVertex> _vertices;
+		std::vector<RecordedInstances> _instanced_draws;
+		std::vector<SpriteInstance> _instances;
+
+		uint32_t get_shader_index(const Shader &shader)
+		{
+			for (size_t i = 0; i < _shaders.size(); i++)
+				if (_shaders[i] == shader)
+					return static_cast<uint32_t>(i);
+			_shaders.push_back(shader);
+			return static_cast<uint32_t>(_shaders.size() - 1);
+		}
+
+		void record(uint64_t state, float min_x, float min_y, float max_x, float max_y, RenderCommandType type,
+					size_t first, size_t count)
+		{
+			if (_queue.is_empty())
+				_queue.set_bounds(get_width(), get_height());
+			_queue.push(_layer, state, min_x, min_y, max_x, max_y, type, static_cast<uint32_t>(first),
+						static_cast<uint32_t>(count));
+		}
+
+	protected:
+		void emit_sprite(const Shader &shader, uint32_t texture_id, const SpriteVertex quad[4]) override
+		{
+			RecordedSprite sprite{get_shader_index(shader), texture_id};
+			std::copy(quad, quad + 4, sprite.quad);
+			_sprites.push_back(sprite);
 
-				// Define model position and scale.
-				model = glm::mat4(1.f);
-				GLfloat xpos = x + ch.bearing.x * scale;
-				GLfloat ypos = y + (font.get_character('H').bearing.y - ch.bearing.y) * scale;
-				model = glm::translate(model, {xpos, ypos, 0.f});
-				GLfloat w = ch.size.x * scale;
-				GLfloat h = ch.size.y * scale;
-				model = glm::scale(model, {w, h, 0.f});
-
-				shader.set_matrix_4f("model", model);
-				// Render glyph texture over quad.
-				glBindTexture(GL_TEXTURE_2D, ch.texture_id);
-				// Render quad.
-				glDrawArrays(GL_TRIANGLES, 0, 6);
-				// Now advance cursors for next glyph.
-				x += (ch.advance >> 6) * scale;
+			float min_x = quad[0].x, min_y = quad[0].y, max_x = quad[0].x, max_y = quad[0].y;
+			for (size_t i = 1; i < 4; i++)
+			{
+				min_x = maths::min(min_x, quad[i].x);
+				min_y = maths::min(min_y, quad[i].y);
+				max_x = maths::max(max_x, quad[i].x);
+				max_y = maths::max(max_y, quad[i].y);
 			}
-			vao::unbind();
-			texture::unbind();
+			record((static_cast<uint64_t>(shader.get_id()) << 32) | texture_id, min_x, min_y, max_x, max_y,
+				   COMMAND_SPRITE, _sprites.size() - 1, 1);
+		}
+
+		void emit_primitives(const ColoredVertex *vertices, size_t count, bool triangles) override
+		{
+			if (count == 0)
+				return;
+			float min_x = vertices[0].x, min_y = vertices[0].y, max_x = vertices[0].x, max_y = vertices[0].y;
+			for (size_t i = 1; i < count; i++)
+			{
+				min_x = maths::min(min_x, vertices[i].x);
+				min_y = maths::min(min_y, vertices[i].y);
+				max_x = maths::max(max_x, vertices[i].x);
+				max_y = maths::max(max_y, vertices[i].y);
+			}
+			auto first = _vertices.size();
+			_vertices.insert(_vertices.end(), vertices, vertices + count);
+			// Lines are rasterized up to half a pixel around their vertices.
+			record((static_cast<uint64_t>(primitive_shader.get_id()) << 32) | (triangles ? 0 : 1), min_x - 1.f,
+				   min_y - 1.f, max_x + 1.f, max_y + 1.f, triangles ? COMMAND_TRIANGLES : COMMAND_LINES, first, count);
+		}
 
-			// Unset OpenGL options
-			DISABLE_OPENGL_OPTIONS;
+		void emit_instances(uint32_t texture_id, const glm::mat4 &projection, const lambdacommon::Color &tint,
+							const SpriteInstance *instances, size_t count) override
+		{
+			_instanced_draws.push_back({texture_id, projection, tint, _instances.size()});
+			_instances.insert(_instances.end(), instances, instances + count);
+			// The instances are placed by the shader, the draw is assumed to cover the whole frame.
+			record(IONIC_COMMAND_UNIQUE_BATCH, 0.f, 0.f, get_floating_width(), get_floating_height(),
+				   COMMAND_INSTANCES, _instanced_draws.size() - 1, count);
+		}
+
+	public:
+		explicit GraphicsGL3Sorted(const Dimension2D_u32 &framebuffer_size) : GraphicsGL3(framebuffer_size)
+		{}
+
+		~GraphicsGL3Sorted() override
+		{
+			flush();
+		}
+
+		void flush() override
+		{
+			// The recorded draws go through the immediate paths, which merge consecutive draws sharing a state.
+			for (const auto &command : _queue.sort())
+			{
+				switch (command.type)
+				{
+					case COMMAND_SPRITE:
+					{
+						const auto &sprite = _sprites[command.first];
+						GraphicsGL3::emit_sprite(_shaders[sprite.shader], sprite.texture, sprite.quad);
+						break;
+					}
+					case COMMAND_TRIANGLES:
+					case COMMAND_LINES:
+						GraphicsGL3::emit_primitives(_vertices.data() + command.first, command.count,
+													 command.type == COMMAND_TRIANGLES);
+						break;
+					case COMMAND_INSTANCES:
+					{
+						const auto &draw = _instanced_draws[command.first];
+						GraphicsGL3::emit_instances(draw.texture, draw.projection, draw.tint,
+													_instances.data() + draw.first, command.count);
+						break;
+					}
+				}
+			}
+			GraphicsGL3::flush();
+
+			_queue.clear();
+			_shaders.clear();
+			_sprites.clear();
+			_vertices.clear();
+			_instanced_draws.clear();
+			_instances.clear();
 		}
 	};
 
@@ -467,30 +807,15 @@ namespace ionicengine
 		register_graphics(GRAPHICS_GL3,
 						  [this](const Dimension2D_u32 &framebuffer_size)
 						  {
-							  return (Graphics *) new GraphicsGL3(framebuffer_size, vao, vbo);
+							  return (Graphics *) new GraphicsGL3(framebuffer_size);
+						  });
+		register_graphics(GRAPHICS_GL3_SORTED,
+						  [this](const Dimension2D_u32 &framebuffer_size)
+						  {
+							  return (Graphics *) new GraphicsGL3Sorted(framebuffer_size);
 						  });
 		_graphics_used = GRAPHICS_GL3;
 
-		// Configure VAO/VBO for texture quads
-		this->vao = vao::generate();
-		this->vbo = vbo::generate();
-		vao::bind(this->vao);
-		vbo::bind(this->vbo);
-		GLfloat text_vertices[6][4] = {
-				{0.f, 1.f, 0.0, 1.0},
-				{1.f, 0.f, 1.0, 0.0},
-				{0.f, 0.f, 0.0, 0.0},
-
-				{0.f, 1.f, 0.0, 1.0},
-				{1.f, 1.f, 1.0, 1.0},
-				{1.f, 0.f, 1.0, 0.0}
-		};
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, text_vertices, GL_STATIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), nullptr);
-		vbo::unbind();
-		vao::unbind();
-
 		shape_quad_init();
 		shape_texture_init();
 
@@ -498,11 +823,16 @@ namespace ionicengine
 			throw std::runtime_error("Cannot load 2d basic shaders.");
 		if (!shader::compile(IONICENGINE_SHADERS_IMAGE))
 			throw std::runtime_error("Cannot load image shaders.");
+		if (!shader::compile(IONICENGINE_SHADERS_SPRITE))
+			throw std::runtime_error("Cannot load sprite shaders.");
+		if (!shader::compile(IONICENGINE_SHADERS_PRIMITIVE))
+			throw std::runtime_error("Cannot load primitive shaders.");
+		if (!shader::compile(IONICENGINE_SHADERS_SPRITE_INSTANCED))
+			throw std::runtime_error("Cannot load instanced sprite shaders.");
 		if (!shader::compile(SHADER_TEXT))
 			throw std::runtime_error("Cannot load text shaders.");
-
-		// Configure Framebuffer
-		this->framebuffer = fbo::generate();
+		if (!shader::compile(SHADER_TEXT_SDF))
+			throw std::runtime_error("Cannot load signed distance field text shaders.");
 	}
 
 	void GraphicsManager::register_graphics(const ResourceName &name, const newGraphicsFunction &newGraphics)
@@ -15,6 +15,16 @@ namespace ionicengine
 	 * Gui
 	 */
 
+	bool Gui::is_dirty() const
+	{
+		return dirty;
+	}
+
+	void Gui::set_dirty(bool dirty)
+	{
+		this->dirty = dirty;
+	}
+
 	lambdacommon::Color Gui::get_background_color() const
 	{
 		return background_color;
@@ -23,6 +33,7 @@ namespace ionicengine
 	void Gui::set_background_color(const lambdacommon::Color &color)
 	{
 		background_color = color;
+		dirty = true;
 	}
 
 	/*
@@ -40,6 +51,17 @@ namespace ionicengine
 	void Border::set_color(const lambdacommon::Color &color)
 	{
 		Border::color = color;
+		dirty = true;
+	}
+
+	bool Border::is_dirty() const
+	{
+		return dirty;
+	}
+
+	void Border::set_dirty(bool dirty)
+	{
+		this->dirty = dirty;
 	}
 
 	void Border::draw(int x, int y, uint32_t width, uint32_t height, Graphics *graphics)
@@ -76,6 +98,18 @@ namespace ionicengine
 		delete border;
 	}
 
+	bool GuiComponent::is_dirty() const
+	{
+		return dirty || (border != nullptr && border->is_dirty());
+	}
+
+	void GuiComponent::set_dirty(bool dirty)
+	{
+		Gui::set_dirty(dirty);
+		if (!dirty && border != nullptr)
+			border->set_dirty(false);
+	}
+
 	const lambdacommon::Color &GuiComponent::get_color() const
 	{
 		return color;
@@ -84,6 +118,7 @@ namespace ionicengine
 	void GuiComponent::set_color(const lambdacommon::Color &color)
 	{
 		this->color = color;
+		dirty = true;
 	}
 
 	Border *GuiComponent::get_border() const
@@ -95,6 +130,7 @@ namespace ionicengine
 	{
 		delete this->border;
 		this->border = border;
+		dirty = true;
 	}
 
 	int GuiComponent::get_x() const
@@ -114,6 +150,8 @@ namespace ionicengine
 
 	void GuiComponent::set_visible(bool visible)
 	{
+		if (this->visible != visible)
+			dirty = true;
 		this->visible = visible;
 	}
 
@@ -124,6 +162,8 @@ namespace ionicengine
 
 	void GuiComponent::set_enabled(bool enabled)
 	{
+		if (this->enabled != enabled)
+			dirty = true;
 		GuiComponent::enabled = enabled;
 	}
 
@@ -134,6 +174,8 @@ namespace ionicengine
 
 	void GuiComponent::set_hovered(bool hovered)
 	{
+		if (this->hovered != hovered)
+			dirty = true;
 		GuiComponent::hovered = hovered;
 	}
 
@@ -144,6 +186,8 @@ namespace ionicengine
 
 	void GuiComponent::set_clicked(bool clicked)
 	{
+		if (this->clicked != clicked)
+			dirty = true;
 		GuiComponent::clicked = clicked;
 	}
 
@@ -215,6 +259,7 @@ namespace ionicengine
 		if (indeterminate)
 		{
 			indeterminate_index += 2;
+			dirty = true;
 			if (indeterminate_index >= (int) width + getIndeterminateBoxLength())
 				indeterminate_index = -getIndeterminateBoxLength();
 		}
@@ -245,7 +290,10 @@ namespace ionicengine
 
 	void GuiProgressBar::set_progress(uint32_t progress)
 	{
-		this->progress = lambdacommon::maths::clamp(progress, (uint32_t) 0, (uint32_t) 100);
+		progress = lambdacommon::maths::clamp(progress, (uint32_t) 0, (uint32_t) 100);
+		if (this->progress != progress)
+			dirty = true;
+		this->progress = progress;
 	}
 
 	bool GuiProgressBar::is_indeterminate() const
@@ -255,6 +303,8 @@ namespace ionicengine
 
 	void GuiProgressBar::set_indeterminate(bool indeterminate)
 	{
+		if (this->indeterminate != indeterminate)
+			dirty = true;
 		this->indeterminate = indeterminate;
 	}
 
@@ -305,22 +355,32 @@ namespace ionicengine
 		}
 		graphics->draw_quad(x, y, width, height);
 		graphics->set_color(color);
+		update_layout();
+		graphics->draw_text(*_layout, x + ((width / 2) - (_layout->get_width() / 2)),
+							y + ((height / 2) - (_layout->get_height() / 2)) + 4);
+
+		border->draw(x, y, width, height, graphics);
+	}
+
+	void GuiButton::update_layout()
+	{
+		if (_layout && _layout_font == font && _layout_width == width && _layout_height == height)
+			return;
+
 		auto drawable_text = text;
-		auto text_height = font->get_text_height(drawable_text);
-		while (text_height > height - 4)
+		while (font->get_text_height(drawable_text) > height - 4)
 		{
 			auto new_line = drawable_text.find_last_of('\n');
 			if (new_line == std::string::npos)
 				// Fuck it and draw it.
 				break;
 			drawable_text = drawable_text.substr(0, new_line + 1);
-			text_height = font->get_text_height(drawable_text);
 		}
 		drawable_text = font->trim_text_to_length_dotted(drawable_text, width - 4);
-		graphics->draw_text(*font, x + ((width / 2) - (font->get_text_length(drawable_text) / 2)),
-							y + ((height / 2) - (text_height / 2)) + 4, drawable_text);
-
-		border->draw(x, y, width, height, graphics);
+		_layout = text_layout::get(*font, drawable_text);
+		_layout_font = font;
+		_layout_width = width;
+		_layout_height = height;
 	}
 
 	void GuiButton::update()
@@ -359,6 +419,7 @@ namespace ionicengine
 	void GuiButton::set_hover_color(const lambdacommon::Color &hoverColor)
 	{
 		GuiButton::hover_color = hoverColor;
+		dirty = true;
 	}
 
 	const lambdacommon::Color &GuiButton::get_click_color() const
@@ -369,6 +430,7 @@ namespace ionicengine
 	void GuiButton::set_click_color(const lambdacommon::Color &clickColor)
 	{
 		GuiButton::click_color = clickColor;
+		dirty = true;
 	}
 
 	void GuiButton::set_activate_listener(const std::function<void(Window &window)> &on_activate_listener)
@@ -384,6 +446,8 @@ namespace ionicengine
 	void GuiButton::set_text(const std::string &text)
 	{
 		GuiButton::text = text;
+		_layout.reset();
+		dirty = true;
 	}
 
 	Font *GuiButton::get_font() const
@@ -394,5 +458,7 @@ namespace ionicengine
 	void GuiButton::set_font(Font *font)
 	{
 		GuiButton::font = font;
+		_layout.reset();
+		dirty = true;
 	}
 }
\ No newline at end of file
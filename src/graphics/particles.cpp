@@ -0,0 +1,348 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../../include/ionicengine/graphics/particles.h"
+#include "../../include/ionicengine/threadpool.h"
+#include <lambdacommon/maths.h>
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define IONIC_PARTICLES_INSTRUCTION_SET "AVX2"
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+#define IONIC_PARTICLES_INSTRUCTION_SET "SSE2"
+#else
+#define IONIC_PARTICLES_INSTRUCTION_SET "scalar"
+#endif
+
+namespace maths = lambdacommon::maths;
+
+namespace ionicengine
+{
+	/*!
+	 * Operations of the update kernel on one float at a time, used for the particles left after the last full register.
+	 */
+	struct ScalarOps
+	{
+		typedef float type;
+		static constexpr size_t WIDTH = 1;
+
+		static type load(const float *p)
+		{ return *p; }
+
+		static void store(float *p, type v)
+		{ *p = v; }
+
+		static type set(float value)
+		{ return value; }
+
+		static type add(type a, type b)
+		{ return a + b; }
+
+		static type sub(type a, type b)
+		{ return a - b; }
+
+		static type mul(type a, type b)
+		{ return a * b; }
+
+		static type min(type a, type b)
+		{ return a < b ? a : b; }
+
+		static type max(type a, type b)
+		{ return a > b ? a : b; }
+	};
+
+#if defined(__AVX2__)
+	struct SimdOps
+	{
+		typedef __m256 type;
+		static constexpr size_t WIDTH = 8;
+
+		static type load(const float *p)
+		{ return _mm256_loadu_ps(p); }
+
+		static void store(float *p, type v)
+		{ _mm256_storeu_ps(p, v); }
+
+		static type set(float value)
+		{ return _mm256_set1_ps(value); }
+
+		static type add(type a, type b)
+		{ return _mm256_add_ps(a, b); }
+
+		static type sub(type a, type b)
+		{ return _mm256_sub_ps(a, b); }
+
+		static type mul(type a, type b)
+		{ return _mm256_mul_ps(a, b); }
+
+		static type min(type a, type b)
+		{ return _mm256_min_ps(a, b); }
+
+		static type max(type a, type b)
+		{ return _mm256_max_ps(a, b); }
+	};
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	struct SimdOps
+	{
+		typedef __m128 type;
+		static constexpr size_t WIDTH = 4;
+
+		static type load(const float *p)
+		{ return _mm_loadu_ps(p); }
+
+		static void store(float *p, type v)
+		{ _mm_storeu_ps(p, v); }
+
+		static type set(float value)
+		{ return _mm_set1_ps(value); }
+
+		static type add(type a, type b)
+		{ return _mm_add_ps(a, b); }
+
+		static type sub(type a, type b)
+		{ return _mm_sub_ps(a, b); }
+
+		static type mul(type a, type b)
+		{ return _mm_mul_ps(a, b); }
+
+		static type min(type a, type b)
+		{ return _mm_min_ps(a, b); }
+
+		static type max(type a, type b)
+		{ return _mm_max_ps(a, b); }
+	};
+#else
+	typedef ScalarOps SimdOps;
+#endif
+
+	/*!
+	 * Pointers to the particle arrays read and written by the update kernel.
+	 */
+	struct ParticleArrays
+	{
+		float *x, *y, *velocity_x, *velocity_y, *life;
+		const float *inverse_lifetime;
+		// Size, red, green, blue and alpha, interpolated with the age of the particles.
+		float *ramps[5];
+	};
+
+	/*!
+	 * Integrates the particles in [begin, end) and interpolates their size and color, {@code Ops::WIDTH} at a time.
+	 * @param begin The first particle, end - begin must be a multiple of the width of the operations.
+	 */
+	template<typename Ops>
+	static void update_particles(const ParticleArrays &arrays, size_t begin, size_t end, float delta,
+								 float acceleration_x, float acceleration_y, const float starts[5],
+								 const float ranges[5])
+	{
+		typedef typename Ops::type V;
+		V dt = Ops::set(delta), zero = Ops::set(0.f), one = Ops::set(1.f);
+		V dvx = Ops::set(acceleration_x * delta), dvy = Ops::set(acceleration_y * delta);
+		V start[5], range[5];
+		for (size_t ramp = 0; ramp < 5; ramp++)
+		{
+			start[ramp] = Ops::set(starts[ramp]);
+			range[ramp] = Ops::set(ranges[ramp]);
+		}
+
+		for (size_t i = begin; i < end; i += Ops::WIDTH)
+		{
+			V velocity_x = Ops::add(Ops::load(arrays.velocity_x + i), dvx);
+			V velocity_y = Ops::add(Ops::load(arrays.velocity_y + i), dvy);
+			Ops::store(arrays.velocity_x + i, velocity_x);
+			Ops::store(arrays.velocity_y + i, velocity_y);
+			Ops::store(arrays.x + i, Ops::add(Ops::load(arrays.x + i), Ops::mul(velocity_x, dt)));
+			Ops::store(arrays.y + i, Ops::add(Ops::load(arrays.y + i), Ops::mul(velocity_y, dt)));
+
+			V life = Ops::sub(Ops::load(arrays.life + i), dt);
+			Ops::store(arrays.life + i, life);
+			// Age between 0 at birth and 1 at death.
+			V age = Ops::min(Ops::max(Ops::sub(one, Ops::mul(life, Ops::load(arrays.inverse_lifetime + i))), zero),
+							 one);
+			for (size_t ramp = 0; ramp < 5; ramp++)
+				Ops::store(arrays.ramps[ramp] + i, Ops::add(start[ramp], Ops::mul(range[ramp], age)));
+		}
+	}
+
+	ParticleSystem::ParticleSystem(size_t max_particles) : _max_particles(max_particles)
+	{
+		for (auto array : {&_x, &_y, &_velocity_x, &_velocity_y, &_life, &_inverse_lifetime, &_size, &_red, &_green,
+						   &_blue, &_alpha})
+			array->resize(max_particles);
+		_instances.reserve(max_particles);
+	}
+
+	size_t ParticleSystem::get_max_particles() const
+	{
+		return _max_particles;
+	}
+
+	size_t ParticleSystem::get_count() const
+	{
+		return _count;
+	}
+
+	void ParticleSystem::set_acceleration(float x, float y)
+	{
+		_acceleration_x = x;
+		_acceleration_y = y;
+	}
+
+	void ParticleSystem::set_color(const lambdacommon::Color &start, const lambdacommon::Color &end)
+	{
+		_start_color = start;
+		_end_color = end;
+	}
+
+	void ParticleSystem::set_size(float start, float end)
+	{
+		_start_size = start;
+		_end_size = end;
+	}
+
+	bool ParticleSystem::is_parallel() const
+	{
+		return _parallel;
+	}
+
+	void ParticleSystem::set_parallel(bool parallel)
+	{
+		_parallel = parallel;
+	}
+
+	bool ParticleSystem::emit(const Particle &particle)
+	{
+		if (_count == _max_particles || particle.lifetime <= 0.f)
+			return false;
+
+		size_t i = _count++;
+		_x[i] = particle.x;
+		_y[i] = particle.y;
+		_velocity_x[i] = particle.velocity_x;
+		_velocity_y[i] = particle.velocity_y;
+		_life[i] = particle.lifetime;
+		_inverse_lifetime[i] = 1.f / particle.lifetime;
+		_size[i] = _start_size;
+		_red[i] = _start_color.red();
+		_green[i] = _start_color.green();
+		_blue[i] = _start_color.blue();
+		_alpha[i] = _start_color.alpha();
+		return true;
+	}
+
+	void ParticleSystem::update_range(size_t begin, size_t end, float delta)
+	{
+		const float starts[5] = {_start_size, _start_color.red(), _start_color.green(), _start_color.blue(),
+								 _start_color.alpha()};
+		const float ranges[5] = {_end_size - _start_size, _end_color.red() - _start_color.red(),
+								 _end_color.green() - _start_color.green(), _end_color.blue() - _start_color.blue(),
+								 _end_color.alpha() - _start_color.alpha()};
+
+		ParticleArrays arrays{_x.data(), _y.data(), _velocity_x.data(), _velocity_y.data(), _life.data(),
+							  _inverse_lifetime.data(),
+							  {_size.data(), _red.data(), _green.data(), _blue.data(), _alpha.data()}};
+		// The SIMD kernel covers whole registers, the scalar one the remaining particles.
+		size_t simd_end = begin + (end - begin) / SimdOps::WIDTH * SimdOps::WIDTH;
+		update_particles<SimdOps>(arrays, begin, simd_end, delta, _acceleration_x, _acceleration_y, starts, ranges);
+		update_particles<ScalarOps>(arrays, simd_end, end, delta, _acceleration_x, _acceleration_y, starts, ranges);
+	}
+
+	void ParticleSystem::remove_dead()
+	{
+		// The last living particle takes the place of a dead one, the order of the particles is not kept.
+		size_t i = 0;
+		while (i < _count)
+		{
+			if (_life[i] > 0.f)
+			{
+				i++;
+				continue;
+			}
+			size_t last = --_count;
+			for (auto array : {&_x, &_y, &_velocity_x, &_velocity_y, &_life, &_inverse_lifetime, &_size, &_red,
+							   &_green, &_blue, &_alpha})
+				(*array)[i] = (*array)[last];
+		}
+	}
+
+	void ParticleSystem::update(float delta)
+	{
+		if (_count == 0)
+			return;
+
+		size_t tasks = 1;
+		auto &pool = get_worker_pool();
+		if (_parallel && _count > IONIC_PARTICLES_PER_TASK)
+			tasks = maths::min(pool.get_thread_count() + 1,
+							   (_count + IONIC_PARTICLES_PER_TASK - 1) / IONIC_PARTICLES_PER_TASK);
+
+		if (tasks == 1)
+			update_range(0, _count, delta);
+		else
+		{
+			// Ranges stay aligned on the SIMD width so only the last one has a scalar tail.
+			size_t per_task = (_count + tasks - 1) / tasks;
+			per_task = (per_task + SimdOps::WIDTH - 1) / SimdOps::WIDTH * SimdOps::WIDTH;
+
+			std::vector<std::future<void>> futures;
+			for (size_t task = 1; task < tasks; task++)
+			{
+				size_t begin = task * per_task, end = maths::min(_count, begin + per_task);
+				if (begin >= end)
+					break;
+				futures.push_back(pool.submit([this, begin, end, delta]()
+											  {
+												  update_range(begin, end, delta);
+											  }));
+			}
+			// The calling thread updates a range too instead of only waiting.
+			update_range(0, maths::min(_count, per_task), delta);
+			for (auto &future : futures)
+				future.get();
+		}
+
+		remove_dead();
+	}
+
+	void ParticleSystem::draw(Graphics *graphics, const Texture &texture)
+	{
+		if (_count == 0)
+			return;
+
+		_instances.resize(_count);
+		for (size_t i = 0; i < _count; i++)
+		{
+			auto &instance = _instances[i];
+			float half_size = _size[i] / 2.f;
+			instance.x = _x[i] - half_size;
+			instance.y = _y[i] - half_size;
+			instance.width = instance.height = _size[i];
+			instance.r = _red[i];
+			instance.g = _green[i];
+			instance.b = _blue[i];
+			instance.a = _alpha[i];
+		}
+		graphics->draw_image_instanced(texture, _instances);
+	}
+
+	void ParticleSystem::clear()
+	{
+		_count = 0;
+	}
+
+	const char *ParticleSystem::get_instruction_set()
+	{
+		return IONIC_PARTICLES_INSTRUCTION_SET;
+	}
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../../include/ionicengine/graphics/rendertarget.h"
+#include "../../include/ionicengine/gl/buffer.h"
+#include "../../include/ionicengine/gl/state.h"
+#include <stdexcept>
+
+namespace ionicengine
+{
+	uint32_t RenderTarget::get_width() const
+	{
+		return _width;
+	}
+
+	uint32_t RenderTarget::get_height() const
+	{
+		return _height;
+	}
+
+	bool RenderTarget::is_created() const
+	{
+		return _framebuffer != 0;
+	}
+
+	void RenderTarget::resize(uint32_t width, uint32_t height)
+	{
+		if (!is_created())
+		{
+			_framebuffer = fbo::generate();
+			glGenTextures(1, &_texture);
+		}
+		_width = width;
+		_height = height;
+
+		glstate::bind_texture(GL_TEXTURE0, _texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		// The target is drawn back pixel for pixel.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		fbo::bind(_framebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _texture, 0);
+		bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		fbo::unbind();
+		if (!complete)
+			throw std::runtime_error("Cannot create a render target of " + std::to_string(width) + "x" +
+									 std::to_string(height) + " pixels.");
+	}
+
+	void RenderTarget::bind() const
+	{
+		fbo::bind(_framebuffer);
+	}
+
+	void RenderTarget::unbind()
+	{
+		fbo::unbind();
+	}
+
+	Texture RenderTarget::get_texture() const
+	{
+		return {_texture, _width, _height, 4};
+	}
+
+	TextureRegion RenderTarget::get_upright_region()
+	{
+		return {0.f, 1.f, 1.f, 0.f};
+	}
+
+	void RenderTarget::destroy()
+	{
+		if (!is_created())
+			return;
+		glDeleteFramebuffers(1, &_framebuffer);
+		glstate::forget_framebuffer(_framebuffer);
+		glDeleteTextures(1, &_texture);
+		glstate::forget_texture(_texture);
+		_framebuffer = _texture = 0;
+		_width = _height = 0;
+	}
+}
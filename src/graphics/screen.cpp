@@ -8,7 +8,16 @@
  */
 
 #include "../../include/ionicengine/graphics/screen.h"
+#include "../../include/ionicengine/gl/state.h"
+#include "../../include/ionicengine/profiler.h"
+#include "../../include/ionicengine/tracing.h"
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#define IONIC_PROFILER_PANEL_WIDTH 360
+#define IONIC_PROFILER_GRAPH_HEIGHT 60
+#define IONIC_PROFILER_GRAPH_MAX_MS 33.3
 
 namespace ionicengine
 {
@@ -21,7 +30,15 @@ namespace ionicengine
 	void Screen::draw(Graphics *graphics)
 	{
 		for (GuiComponent *component : components)
+		{
+			// Same margin as the damage of the components.
+			if (redraw_area && (component->get_x() - 1 >= redraw_area->max_x ||
+								component->get_x() + static_cast<int>(component->width) + 1 <= redraw_area->min_x ||
+								component->get_y() - 1 >= redraw_area->max_y ||
+								component->get_y() + static_cast<int>(component->height) + 1 <= redraw_area->min_y))
+				continue;
 			component->draw(graphics);
+		}
 	}
 
 	void Screen::update()
@@ -37,6 +54,169 @@ namespace ionicengine
 		for (GuiComponent *component : components)
 			delete component;
 		components.clear();
+		dirty = true;
+	}
+
+	void Screen::collect_damage()
+	{
+		// One more pixel around the components covers the outlines of their borders.
+		for (GuiComponent *component : components)
+			if (component->is_dirty())
+				add_damage(component->get_x() - 1, component->get_y() - 1, component->width + 2,
+						   component->height + 2);
+	}
+
+	bool Screen::is_dirty() const
+	{
+		if (dirty || !damage.empty())
+			return true;
+		for (GuiComponent *component : components)
+			if (component->is_dirty())
+				return true;
+		return false;
+	}
+
+	void Screen::set_dirty(bool dirty)
+	{
+		Gui::set_dirty(dirty);
+		if (!dirty)
+		{
+			damage.clear();
+			for (GuiComponent *component : components)
+				component->set_dirty(false);
+		}
+	}
+
+	void Screen::add_damage(int x, int y, uint32_t width, uint32_t height)
+	{
+		if (width == 0 || height == 0)
+			return;
+		DamageRect rect{x, y, x + static_cast<int>(width), y + static_cast<int>(height)};
+		// A merged rectangle may overlap rectangles it didn't overlap before, the search restarts after a merge.
+		bool merged = true;
+		while (merged)
+		{
+			merged = false;
+			for (auto it = damage.begin(); it != damage.end(); ++it)
+			{
+				if (it->min_x > rect.max_x || rect.min_x > it->max_x || it->min_y > rect.max_y || rect.min_y > it->max_y)
+					continue;
+				rect = {std::min(rect.min_x, it->min_x), std::min(rect.min_y, it->min_y),
+						std::max(rect.max_x, it->max_x), std::max(rect.max_y, it->max_y)};
+				damage.erase(it);
+				merged = true;
+				break;
+			}
+		}
+		damage.push_back(rect);
+
+		if (damage.size() > IONIC_SCREEN_MAX_DAMAGE_RECTS)
+		{
+			for (const auto &other : damage)
+				rect = {std::min(rect.min_x, other.min_x), std::min(rect.min_y, other.min_y),
+						std::max(rect.max_x, other.max_x), std::max(rect.max_y, other.max_y)};
+			damage.assign(1, rect);
+		}
+	}
+
+	const std::vector<DamageRect> &Screen::get_damage() const
+	{
+		return damage;
+	}
+
+	bool Screen::is_cached() const
+	{
+		return cached;
+	}
+
+	void Screen::set_cached(bool cached)
+	{
+		this->cached = cached;
+		dirty = true;
+	}
+
+	void Screen::draw_cached(Graphics *graphics, const Dimension2D_u32 &framebuffer_size)
+	{
+		if (!cached)
+		{
+			// The cache of a screen no longer cached is deleted here, where the context is current.
+			release_cache();
+			draw(graphics);
+			graphics->reset_transform();
+			return;
+		}
+
+		if (!cache.is_created() || cache.get_width() != framebuffer_size.get_width() ||
+			cache.get_height() != framebuffer_size.get_height())
+		{
+			cache.resize(framebuffer_size.get_width(), framebuffer_size.get_height());
+			dirty = true;
+		}
+		if (!dirty)
+			collect_damage();
+		if (dirty || !damage.empty())
+		{
+			graphics->flush();
+			cache.bind();
+			auto background = get_background_color();
+			glClearColor(background.red() * background.alpha(), background.green() * background.alpha(),
+						 background.blue() * background.alpha(), background.alpha());
+			if (dirty)
+			{
+				glClear(GL_COLOR_BUFFER_BIT);
+				draw(graphics);
+				graphics->reset_transform();
+				graphics->flush();
+			}
+			else
+			{
+				// The cache keeps the rest of the screen, the bounding box of the damage is cleared and drawn again
+				// in one pass.
+				DamageRect area = damage.front();
+				for (const auto &rect : damage)
+					area = {std::min(area.min_x, rect.min_x), std::min(area.min_y, rect.min_y),
+							std::max(area.max_x, rect.max_x), std::max(area.max_y, rect.max_y)};
+
+				float scale_x = framebuffer_size.get_width() / graphics->get_floating_width();
+				float scale_y = framebuffer_size.get_height() / graphics->get_floating_height();
+				auto to_pixels = [](float value, uint32_t size)
+				{
+					return lambdacommon::maths::clamp(static_cast<int>(value), 0, static_cast<int>(size));
+				};
+				// The rows of the cache start at the bottom of the screen.
+				int min_x = to_pixels(std::floor(area.min_x * scale_x), framebuffer_size.get_width());
+				int max_x = to_pixels(std::ceil(area.max_x * scale_x), framebuffer_size.get_width());
+				int min_y = to_pixels(framebuffer_size.get_height() - std::ceil(area.max_y * scale_y),
+									  framebuffer_size.get_height());
+				int max_y = to_pixels(framebuffer_size.get_height() - std::floor(area.min_y * scale_y),
+									  framebuffer_size.get_height());
+				if (min_x < max_x && min_y < max_y)
+				{
+					glstate::enable(GL_SCISSOR_TEST);
+					glScissor(min_x, min_y, max_x - min_x, max_y - min_y);
+					glClear(GL_COLOR_BUFFER_BIT);
+					redraw_area = area;
+					draw(graphics);
+					redraw_area.reset();
+					graphics->reset_transform();
+					graphics->flush();
+					glstate::disable(GL_SCISSOR_TEST);
+				}
+			}
+			RenderTarget::unbind();
+			set_dirty(false);
+		}
+
+		graphics->set_color(lambdacommon::Color::COLOR_WHITE);
+		graphics->set_blend_mode(BLEND_PREMULTIPLIED);
+		graphics->draw_image(cache.get_texture(), 0.f, 0.f, graphics->get_floating_width(),
+							 graphics->get_floating_height(), RenderTarget::get_upright_region());
+		graphics->set_blend_mode(BLEND_ALPHA);
+	}
+
+	void Screen::release_cache()
+	{
+		cache.destroy();
 	}
 
 	GuiComponent *Screen::get_focused_component() const
@@ -242,6 +422,17 @@ namespace ionicengine
 	{
 		graphics->set_color(lambdacommon::Color::COLOR_WHITE);
 		graphics->draw_text(_font, 2, 3, "FPS: " + std::to_string(_fps));
+		if (!_show_render_stats)
+			return;
+
+		int line_height = static_cast<int>(_font.get_height());
+		graphics->draw_text(_font, 2, 3 + line_height,
+							"Draw calls: " + std::to_string(_render_stats.draw_calls) + " Vertices: " +
+							std::to_string(_render_stats.vertices));
+		graphics->draw_text(_font, 2, 3 + line_height * 2,
+							"Programs: " + std::to_string(_render_stats.program_switches) + " Textures: " +
+							std::to_string(_render_stats.texture_binds) + " Uploads: " +
+							std::to_string(_render_stats.buffer_uploads));
 	}
 
 	void OverlayFPS::update()
@@ -249,9 +440,108 @@ namespace ionicengine
 
 	void OverlayFPS::updateFPS(int fps)
 	{
+		if (_fps != fps)
+			dirty = true;
 		_fps = fps;
 	}
 
+	bool OverlayFPS::is_showing_render_stats() const
+	{
+		return _show_render_stats;
+	}
+
+	void OverlayFPS::set_show_render_stats(bool show)
+	{
+		if (_show_render_stats != show)
+			dirty = true;
+		_show_render_stats = show;
+	}
+
+	void OverlayFPS::update_render_stats(const RenderStats &stats)
+	{
+		if (_show_render_stats)
+			dirty = true;
+		_render_stats = stats;
+	}
+
+	/*
+	 * OVERLAY PROFILER
+	 */
+
+	static std::string format_ms(double ms)
+	{
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), "%.2f", ms);
+		return buffer;
+	}
+
+	OverlayProfiler::OverlayProfiler(const Font &font) : Overlay(), _font(font)
+	{}
+
+	void OverlayProfiler::init()
+	{}
+
+	void OverlayProfiler::draw(Graphics *graphics)
+	{
+		int x = static_cast<int>(width) - IONIC_PROFILER_PANEL_WIDTH;
+		int line_height = static_cast<int>(_font.get_height());
+		const auto *frame = profiler::get_resolved_frame();
+		if (!profiler::is_enabled() || frame == nullptr)
+		{
+			graphics->set_color(lambdacommon::Color::COLOR_WHITE);
+			graphics->draw_text(_font, x + 4, 3, "Profiler disabled");
+			return;
+		}
+
+		int graph_y = (static_cast<int>(frame->samples.size()) + 1) * line_height + 8;
+		graphics->set_color(lambdacommon::Color(.0f, .0f, .0f, .6f));
+		graphics->draw_quad(x, 0, IONIC_PROFILER_PANEL_WIDTH, graph_y + IONIC_PROFILER_GRAPH_HEIGHT + 4);
+
+		graphics->set_color(lambdacommon::Color::COLOR_WHITE);
+		graphics->draw_text(_font, x + 4, 3, "Frame " + std::to_string(frame->index) + ": " +
+											 format_ms(frame->frame_ms) + " ms");
+		graphics->draw_text(_font, x + 200, 3, "calls   cpu     gpu");
+		int y = 3 + line_height;
+		for (const auto &sample : frame->samples)
+		{
+			graphics->draw_text(_font, x + 4 + static_cast<int>(sample.depth) * 8, y, sample.name);
+			graphics->draw_text(_font, x + 200, y,
+								std::to_string(sample.calls) + "   " + format_ms(sample.cpu_ms) + "   " +
+								(sample.gpu_ms < 0.0 ? std::string{"-"} : format_ms(sample.gpu_ms)));
+			y += line_height;
+		}
+
+		// One bar per past frame, green within 60 FPS, yellow within 30 FPS, else red.
+		const auto &history = profiler::get_history();
+		float bar_width = static_cast<float>(IONIC_PROFILER_PANEL_WIDTH) / IONIC_PROFILER_HISTORY;
+		float bar_x = x + IONIC_PROFILER_PANEL_WIDTH - history.size() * bar_width;
+		float graph_bottom = graph_y + IONIC_PROFILER_GRAPH_HEIGHT;
+		for (const auto &past : history)
+		{
+			auto ratio = static_cast<float>(lambdacommon::maths::min(past.frame_ms / IONIC_PROFILER_GRAPH_MAX_MS, 1.0));
+			if (past.frame_ms <= 16.7)
+				graphics->set_color(lambdacommon::Color(.2f, .8f, .2f, 1.f));
+			else if (past.frame_ms <= IONIC_PROFILER_GRAPH_MAX_MS)
+				graphics->set_color(lambdacommon::Color(.9f, .8f, .1f, 1.f));
+			else
+				graphics->set_color(lambdacommon::Color(.9f, .2f, .2f, 1.f));
+			float bar_height = ratio * IONIC_PROFILER_GRAPH_HEIGHT;
+			graphics->draw_quad(bar_x, graph_bottom - bar_height, bar_width, bar_height);
+			bar_x += bar_width;
+		}
+		graphics->set_color(lambdacommon::Color(1.f, 1.f, 1.f, .5f));
+		float target_y = graph_bottom - static_cast<float>(16.7 / IONIC_PROFILER_GRAPH_MAX_MS) *
+										IONIC_PROFILER_GRAPH_HEIGHT;
+		graphics->draw_line_2d(static_cast<float>(x), target_y, static_cast<float>(x + IONIC_PROFILER_PANEL_WIDTH),
+							   target_y);
+	}
+
+	void OverlayProfiler::update()
+	{
+		// The profiled values change every frame.
+		dirty = true;
+	}
+
 	/*
 	 * SCREENMANAGER
 	 */
@@ -262,7 +552,7 @@ namespace ionicengine
 		last_screen_manager_id++;
 		lambdacommon::ResourceName nullScreen{"ionicengine", "screens/null"};
 		register_screen(nullScreen, new NullScreen());
-		_active_screen = nullScreen;
+		_active_screen = resource::intern(nullScreen);
 	}
 
 	ScreenManager::~ScreenManager()
@@ -272,42 +562,56 @@ namespace ionicengine
 
 	void ScreenManager::register_screen(const lambdacommon::ResourceName &name, Screen *screen)
 	{
-		if (_screens.count(name))
+		auto handle = resource::intern(name);
+		if (_screens.has(handle))
 			throw std::invalid_argument(
 					"ScreenManager has already registered the screen with name '" + name.to_string() + "'!");
-		_screens[name] = screen;
+		_screens.set(handle, screen);
 	}
 
 	bool ScreenManager::has_screen(const lambdacommon::ResourceName &name) const
 	{
-		return static_cast<bool>(_screens.count(name));
+		return _screens.has(resource::find(name));
 	}
 
 	Screen *ScreenManager::get_screen(const lambdacommon::ResourceName &name) const
 	{
-		if (!has_screen(name))
+		return get_screen(resource::find(name));
+	}
+
+	Screen *ScreenManager::get_screen(ResourceHandle screen) const
+	{
+		auto stored_screen = _screens.find(screen);
+		if (stored_screen == nullptr)
 			return nullptr;
-		return _screens.at(name);
+		return *stored_screen;
 	}
 
 	void ScreenManager::register_overlay(const lambdacommon::ResourceName &name, Overlay *overlay)
 	{
-		if (_overlays.count(name))
+		auto handle = resource::intern(name);
+		if (_overlays.has(handle))
 			throw std::invalid_argument(
 					"GraphicsManager has already registered the overlay with name '" + name.to_string() + "'!");
-		_overlays[name] = overlay;
+		_overlays.set(handle, overlay);
 	}
 
 	bool ScreenManager::has_overlay(const lambdacommon::ResourceName &name) const
 	{
-		return static_cast<bool>(_overlays.count(name));
+		return _overlays.has(resource::find(name));
 	}
 
 	Overlay *ScreenManager::get_overlay(const lambdacommon::ResourceName &name) const
 	{
-		if (!has_overlay(name))
+		return get_overlay(resource::find(name));
+	}
+
+	Overlay *ScreenManager::get_overlay(ResourceHandle overlay) const
+	{
+		auto stored_overlay = _overlays.find(overlay);
+		if (stored_overlay == nullptr)
 			return nullptr;
-		return _overlays.at(name);
+		return *stored_overlay;
 	}
 
 	Screen *ScreenManager::get_active_screen() const
@@ -317,7 +621,8 @@ namespace ionicengine
 
 	void ScreenManager::set_active_screen(const lambdacommon::ResourceName &name)
 	{
-		_active_screen = name;
+		_active_screen = resource::intern(name);
+		_redraw_requested = true;
 		auto screen = get_active_screen();
 		if (screen != nullptr)
 		{
@@ -328,15 +633,20 @@ namespace ionicengine
 
 	std::vector<lambdacommon::ResourceName> ScreenManager::get_active_overlays() const
 	{
-		return _active_overlays;
+		std::vector<lambdacommon::ResourceName> active_overlays;
+		for (auto active_overlay : _active_overlays)
+			active_overlays.push_back(resource::get_name(active_overlay));
+		return active_overlays;
 	}
 
 	void ScreenManager::add_active_overlay(const lambdacommon::ResourceName &name)
 	{
 		if (!is_overlay_active(name))
 		{
-			_active_overlays.emplace_back(name);
-			auto overlay = _overlays.at(name);
+			auto handle = resource::intern(name);
+			_active_overlays.emplace_back(handle);
+			_redraw_requested = true;
+			auto overlay = _overlays.at(handle);
 			if (overlay != nullptr)
 			{
 				overlay->refresh(old_framebuffer_size.get_width(), old_framebuffer_size.get_height());
@@ -347,13 +657,18 @@ namespace ionicengine
 
 	bool ScreenManager::is_overlay_active(const lambdacommon::ResourceName &name)
 	{
-		return std::find(_active_overlays.begin(), _active_overlays.end(), name) != _active_overlays.end();
+		return std::find(_active_overlays.begin(), _active_overlays.end(), resource::find(name)) !=
+			   _active_overlays.end();
 	}
 
 	void ScreenManager::remove_active_overlay(const lambdacommon::ResourceName &name)
 	{
-		if (is_overlay_active(name))
-			_active_overlays.erase(std::find(_active_overlays.begin(), _active_overlays.end(), name));
+		auto active_overlay = std::find(_active_overlays.begin(), _active_overlays.end(), resource::find(name));
+		if (active_overlay != _active_overlays.end())
+		{
+			_active_overlays.erase(active_overlay);
+			_redraw_requested = true;
+		}
 	}
 
 	std::optional<Window> ScreenManager::get_attached_window() const
@@ -371,6 +686,18 @@ namespace ionicengine
 		return updates;
 	}
 
+	RenderStats ScreenManager::get_frame_stats() const
+	{
+		std::lock_guard<std::mutex> lock{_stats_mutex};
+		return _frame_stats;
+	}
+
+	RenderStats ScreenManager::get_total_stats() const
+	{
+		std::lock_guard<std::mutex> lock{_stats_mutex};
+		return _total_stats;
+	}
+
 	float ScreenManager::get_delta_time() const
 	{
 		return delta_time;
@@ -385,12 +712,14 @@ namespace ionicengine
 	{
 		if (!_window)
 			return false;
+		// The input may change what the screens look like.
+		_redraw_requested = true;
 
 		for (const auto &active_overlay : _active_overlays)
 		{
-			if (has_overlay(active_overlay))
+			Overlay *overlay = get_overlay(active_overlay);
+			if (overlay != nullptr)
 			{
-				Overlay *overlay = get_overlay(active_overlay);
 				if (overlay->on_mouse_move(x, y))
 					return true;
 			}
@@ -404,14 +733,15 @@ namespace ionicengine
 	{
 		if (!_window)
 			return false;
+		_redraw_requested = true;
 
 		auto cursor_position = _window->get_cursor_position();
 
 		for (const auto &active_overlay : _active_overlays)
 		{
-			if (has_overlay(active_overlay))
+			Overlay *overlay = get_overlay(active_overlay);
+			if (overlay != nullptr)
 			{
-				Overlay *overlay = get_overlay(active_overlay);
 				if (action == InputAction::PRESS)
 				{
 					if (overlay->on_mouse_pressed(_window.value(), button, static_cast<int>(cursor_position.first),
@@ -448,12 +778,14 @@ namespace ionicengine
 	{
 		if (!_window)
 			return false;
+		_redraw_requested = true;
 
 		for (const auto &active_overlay : _active_overlays)
 		{
-			if (has_overlay(active_overlay))
+			Overlay *overlay = get_overlay(active_overlay);
+			if (overlay != nullptr)
 			{
-				if (get_overlay(active_overlay)->on_key_input(_window.value(), key, scancode, action, mods))
+				if (overlay->on_key_input(_window.value(), key, scancode, action, mods))
 					return true;
 			}
 		}
@@ -465,12 +797,14 @@ namespace ionicengine
 	{
 		if (!_window)
 			return false;
+		_redraw_requested = true;
 
 		for (const auto &active_overlay : _active_overlays)
 		{
-			if (has_overlay(active_overlay))
+			Overlay *overlay = get_overlay(active_overlay);
+			if (overlay != nullptr)
 			{
-				if (get_overlay(active_overlay)->on_gamepad_button_input(_window.value(), action, button))
+				if (overlay->on_gamepad_button_input(_window.value(), action, button))
 					return true;
 			}
 		}
@@ -478,11 +812,162 @@ namespace ionicengine
 		return get_active_screen()->on_gamepad_button_input(_window.value(), action, button);
 	}
 
+	void ScreenManager::draw_frame(Graphics *graphics)
+	{
+		auto framebuffer_size = _window->get_framebuffer_size();
+		auto draw_screen = [this, graphics, &framebuffer_size](Screen *screen)
+		{
+			// The caches are OpenGL objects, a recorded frame draws the screens directly.
+			if (_render_thread)
+			{
+				screen->draw(graphics);
+				graphics->reset_transform();
+			}
+			else
+			{
+				screen->draw_cached(graphics, framebuffer_size);
+				// The screen may have changed the OpenGL state with raw calls, behind the state cache.
+				glstate::invalidate();
+			}
+		};
+
+		auto screen = get_active_screen();
+		if (screen != nullptr)
+			draw_screen(screen);
+		for (const auto &active_overlay : _active_overlays)
+		{
+			Overlay *overlay = get_overlay(active_overlay);
+			if (overlay != nullptr)
+				draw_screen(overlay);
+		}
+	}
+
+	void ScreenManager::release_caches()
+	{
+		_screens.for_each([](ResourceHandle handle, Screen *screen)
+						  {
+							  screen->release_cache();
+						  });
+		_overlays.for_each([](ResourceHandle handle, Overlay *overlay)
+						   {
+							   overlay->release_cache();
+						   });
+	}
+
+	void ScreenManager::publish_render_stats(Graphics *graphics)
+	{
+		graphics->end_frame_stats();
+		std::lock_guard<std::mutex> lock{_stats_mutex};
+		_frame_stats = graphics->get_frame_stats();
+		_total_stats = graphics->get_total_stats();
+	}
+
+	void ScreenManager::run_render_tasks()
+	{
+		std::vector<std::function<void()>> tasks;
+		{
+			std::lock_guard<std::mutex> lock{_render_tasks_mutex};
+			tasks.swap(_render_tasks);
+		}
+		for (const auto &task : tasks)
+			task();
+	}
+
+	void ScreenManager::run_render_thread()
+	{
+		tracing::set_thread_name("Render");
+		_window->request_context();
+		Dimension2D_u32 viewport_size = _window->get_framebuffer_size();
+		while (true)
+		{
+			const DrawList *list;
+			{
+				std::unique_lock<std::mutex> lock{_frame_mutex};
+				_frame_condition.wait(lock, [this]()
+				{
+					return _frame_ready || _stop_rendering;
+				});
+				if (_stop_rendering)
+					break;
+				list = &_draw_lists[_record_list];
+				_record_list = 1 - _record_list;
+				_frame_ready = false;
+			}
+			// Wakes the main thread up so it records the next frame while this one is drawn.
+			glfwPostEmptyEvent();
+
+			{
+				IONIC_TRACE_SCOPE("ScreenManager::replay");
+				run_render_tasks();
+				texture::process_uploads();
+
+				if (list->get_framebuffer_size() != graphics->get_framebuffer_size())
+					graphics->update_framebuffer_size(list->get_framebuffer_size().get_width(),
+													  list->get_framebuffer_size().get_height());
+				if (list->get_viewport_size() != viewport_size)
+				{
+					viewport_size = list->get_viewport_size();
+					glViewport(0, 0, viewport_size.get_width(), viewport_size.get_height());
+				}
+				auto background_color = list->get_background_color();
+				glClearColor(background_color.red(), background_color.green(), background_color.blue(),
+							 background_color.alpha());
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				list->replay(graphics);
+				publish_render_stats(graphics);
+			}
+
+			{
+				IONIC_TRACE_SCOPE("ScreenManager::swap_buffers");
+				glfwSwapBuffers(_window->get_handle());
+			}
+			_rendered_frames++;
+		}
+
+		// The OpenGL objects of the graphics are deleted while the context is still current.
+		LCOMMON_DELETE_POINTER(graphics);
+		glfwMakeContextCurrent(nullptr);
+	}
+
+	const LoopOptions &ScreenManager::get_loop_options() const
+	{
+		return _loop_options;
+	}
+
+	void ScreenManager::set_loop_options(const LoopOptions &options)
+	{
+		_loop_options = options;
+	}
+
+	void ScreenManager::request_redraw()
+	{
+		_redraw_requested = true;
+	}
+
+	bool ScreenManager::has_render_thread() const
+	{
+		return _render_thread;
+	}
+
+	void ScreenManager::set_render_thread(bool render_thread)
+	{
+		_render_thread = render_thread;
+	}
+
+	void ScreenManager::run_on_render_thread(const std::function<void()> &task)
+	{
+		std::lock_guard<std::mutex> lock{_render_tasks_mutex};
+		_render_tasks.push_back(task);
+	}
+
 	void ScreenManager::render()
 	{
 		if (_window)
 		{
 			_window->request_context();
+			// The timestamp queries of the scope need the context.
+			IONIC_PROFILE_GPU_SCOPE("ScreenManager::render");
+			IONIC_TRACE_SCOPE("ScreenManager::render");
 			auto screen = get_active_screen();
 			auto background_color = lambdacommon::Color::COLOR_BLACK;
 			if (screen != nullptr)
@@ -490,33 +975,24 @@ namespace ionicengine
 			glClearColor(background_color.red(), background_color.green(), background_color.blue(),
 						 background_color.alpha());
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			if (screen != nullptr)
-			{
-				screen->draw(graphics);
-				graphics->reset_transform();
-			}
-			for (const auto &active_overlay : _active_overlays)
-			{
-				if (has_overlay(active_overlay))
-				{
-					Overlay *overlay = get_overlay(active_overlay);
-					overlay->draw(graphics);
-					graphics->reset_transform();
-				}
-			}
+			draw_frame(graphics);
+			// Submits the last batched draws of the frame.
+			graphics->flush();
 		}
 	}
 
 	void ScreenManager::update()
 	{
+		IONIC_PROFILE_SCOPE("ScreenManager::update");
+		IONIC_TRACE_SCOPE("ScreenManager::update");
 		auto screen = get_active_screen();
 		if (screen != nullptr)
 			screen->update();
 		for (const auto &active_overlay : _active_overlays)
 		{
-			if (_overlays.count(active_overlay))
+			Overlay *overlay = get_overlay(active_overlay);
+			if (overlay != nullptr)
 			{
-				Overlay *overlay = _overlays.at(active_overlay);
 				overlay->update();
 			}
 		}
@@ -530,6 +1006,11 @@ namespace ionicengine
 		auto size = _window->get_framebuffer_size();
 		graphics = get_graphics_manager()->new_graphics(size);
 		old_framebuffer_size = {0, 0};
+
+		if (_loop_options.swap_interval)
+			glfwSwapInterval(*_loop_options.swap_interval);
+		_next_frame_time = glfwGetTime();
+		_redraw_requested = true;
 	}
 
 	void ScreenManager::start_loop()
@@ -540,36 +1021,140 @@ namespace ionicengine
 		double deltaTime = 0, nowTime = 0;
 		int frames = 0, updates = 0;
 
+		if (_render_thread)
+		{
+			start_threaded_loop();
+			return;
+		}
+
 		glfwSetFramebufferSizeCallback(_window->get_handle(), [](GLFWwindow *window, int width, int height)
 		{
 			glViewport(0, 0, width, height);
 		});
 
+		tracing::set_thread_name("Main");
 		while (!_window->should_close())
 		{
-			auto current_size = _window->get_size();
-			if (old_framebuffer_size != current_size)
+			check_framebuffer_size(graphics);
+
+			// Streams the textures loaded asynchronously, within the per-frame budget.
 			{
-				graphics->update_framebuffer_size(current_size.get_width(), current_size.get_height());
-				old_framebuffer_size = current_size;
-				auto screen = get_active_screen();
-				if (screen != nullptr)
+				IONIC_TRACE_SCOPE("texture::process_uploads");
+				texture::process_uploads();
+			}
+			bool draw = needs_frame() && glfwGetTime() >= _next_frame_time;
+			if (draw)
+			{
+				tracing::instant("ScreenManager::frame");
+				profiler::new_frame();
+				get_font_manager()->new_frame();
+				this->render();
+				publish_render_stats(graphics);
+			}
+
+			nowTime = glfwGetTime();
+			deltaTime += (nowTime - lastTime);
+			lastTime = nowTime;
+
+			this->delta_time = static_cast<float>(deltaTime);
+
+			if (deltaTime >= 0.020)
+			{
+				this->update();
+				updates++;
+				deltaTime = 0;
+			}
+
+			if (draw)
+			{
+				frames++;
 				{
-					screen->refresh(current_size.get_width(), current_size.get_height());
-					screen->init();
+					IONIC_PROFILE_SCOPE("ScreenManager::swap_buffers");
+					IONIC_TRACE_SCOPE("ScreenManager::swap_buffers");
+					glfwSwapBuffers(_window->get_handle());
 				}
-				for (const auto &active_overlay : _active_overlays)
+				on_frame_drawn(glfwGetTime());
+			}
+
+			// Without a frame to draw, sleeps until an input or the next update.
+			double next_update = lastTime + 0.020 - deltaTime;
+			{
+				IONIC_TRACE_SCOPE("ScreenManager::wait");
+				if (needs_frame())
+					wait_until(lambdacommon::maths::min(next_update, _next_frame_time));
+				else
+					glfwWaitEventsTimeout(lambdacommon::maths::max(0.0, next_update - glfwGetTime()));
+			}
+
+			// - Reset after one second
+			if (glfwGetTime() - timer > 1.0)
+			{
+				timer++;
+				this->fps = frames;
+				this->updates = updates;
+				if (has_overlay(IONICENGINE_OVERLAYS_FPS))
 				{
-					if (has_overlay(active_overlay))
-					{
-						Overlay *overlay = get_overlay(active_overlay);
-						overlay->refresh(current_size.get_width(), current_size.get_height());
-						overlay->init();
-					}
+					auto overlay = (OverlayFPS *) get_overlay(IONICENGINE_OVERLAYS_FPS);
+					overlay->updateFPS(frames);
+					overlay->update_render_stats(get_frame_stats());
 				}
+				updates = 0, frames = 0;
 			}
+		}
+
+		release_caches();
+		LCOMMON_DELETE_POINTER(graphics);
+
+		_window->destroy();
+	}
+
+	void ScreenManager::start_threaded_loop()
+	{
+		double lastTime = glfwGetTime(), timer = lastTime;
+		double deltaTime = 0, nowTime = 0;
+		int updates = 0;
+
+		// The screens draw into a recording graphics, the real one belongs to the render thread with the context.
+		Graphics *recorder = new RecordingGraphics(_window->get_size());
+		_stop_rendering = false;
+		_frame_ready = false;
+		_rendered_frames = 0;
+		glfwMakeContextCurrent(nullptr);
+		std::thread render_thread{&ScreenManager::run_render_thread, this};
+
+		tracing::set_thread_name("Main");
+		while (!_window->should_close())
+		{
+			check_framebuffer_size(recorder);
 
-			this->render();
+			// The list of the next frame can be recorded only once the render thread took the previous one.
+			bool pending;
+			{
+				std::lock_guard<std::mutex> lock{_frame_mutex};
+				pending = _frame_ready;
+			}
+			if (!pending && needs_frame() && glfwGetTime() >= _next_frame_time)
+			{
+				tracing::instant("ScreenManager::frame");
+				profiler::new_frame();
+				IONIC_PROFILE_SCOPE("ScreenManager::record");
+				IONIC_TRACE_SCOPE("ScreenManager::record");
+				get_font_manager()->new_frame();
+				auto &list = _draw_lists[_record_list];
+				((RecordingGraphics *) recorder)->begin(list);
+				list.set_viewport_size(_window->get_framebuffer_size());
+				auto screen = get_active_screen();
+				list.set_background_color(screen != nullptr ? screen->get_background_color()
+															: lambdacommon::Color::COLOR_BLACK);
+				draw_frame(recorder);
+				{
+					std::lock_guard<std::mutex> lock{_frame_mutex};
+					_frame_ready = true;
+				}
+				_frame_condition.notify_one();
+				pending = true;
+				on_frame_drawn(glfwGetTime());
+			}
 
 			nowTime = glfwGetTime();
 			deltaTime += (nowTime - lastTime);
@@ -583,28 +1168,130 @@ namespace ionicengine
 				updates++;
 				deltaTime = 0;
 			}
-			frames++;
 
-			glfwSwapBuffers(_window->get_handle());
-			glfwPollEvents();
+			// Sleeps until an input, the next update, or the render thread taking the recorded frame.
+			double next_update = lastTime + 0.020 - deltaTime;
+			{
+				IONIC_TRACE_SCOPE("ScreenManager::wait");
+				if (!pending && needs_frame())
+					wait_until(lambdacommon::maths::min(next_update, _next_frame_time));
+				else
+					glfwWaitEventsTimeout(lambdacommon::maths::max(0.0, next_update - glfwGetTime()));
+			}
 
 			// - Reset after one second
 			if (glfwGetTime() - timer > 1.0)
 			{
 				timer++;
+				int frames = _rendered_frames.exchange(0);
 				this->fps = frames;
 				this->updates = updates;
 				if (has_overlay(IONICENGINE_OVERLAYS_FPS))
-					((OverlayFPS *) get_overlay(IONICENGINE_OVERLAYS_FPS))->updateFPS(frames);
-				updates = 0, frames = 0;
+				{
+					auto overlay = (OverlayFPS *) get_overlay(IONICENGINE_OVERLAYS_FPS);
+					overlay->updateFPS(frames);
+					overlay->update_render_stats(get_frame_stats());
+				}
+				updates = 0;
 			}
 		}
 
-		LCOMMON_DELETE_POINTER(graphics);
+		{
+			std::lock_guard<std::mutex> lock{_frame_mutex};
+			_stop_rendering = true;
+		}
+		_frame_condition.notify_one();
+		render_thread.join();
+
+		delete recorder;
+		_window->request_context();
 
 		_window->destroy();
 	}
 
+	double ScreenManager::get_frame_interval() const
+	{
+		uint32_t fps = _loop_options.target_fps;
+		if (_loop_options.unfocused_fps != 0 && !_window->is_focused())
+			fps = fps == 0 ? _loop_options.unfocused_fps : lambdacommon::maths::min(fps, _loop_options.unfocused_fps);
+		return fps == 0 ? 0.0 : 1.0 / fps;
+	}
+
+	bool ScreenManager::needs_frame() const
+	{
+		if (_loop_options.pause_when_iconified && _window->is_iconified())
+			return false;
+		if (!_loop_options.on_demand || _redraw_requested)
+			return true;
+		auto screen = get_active_screen();
+		if (screen != nullptr && screen->is_dirty())
+			return true;
+		for (const auto &active_overlay : _active_overlays)
+		{
+			Overlay *overlay = get_overlay(active_overlay);
+			if (overlay != nullptr && overlay->is_dirty())
+				return true;
+		}
+		return false;
+	}
+
+	void ScreenManager::on_frame_drawn(double now)
+	{
+		_redraw_requested = false;
+		auto screen = get_active_screen();
+		if (screen != nullptr)
+			screen->set_dirty(false);
+		for (const auto &active_overlay : _active_overlays)
+		{
+			Overlay *overlay = get_overlay(active_overlay);
+			if (overlay != nullptr)
+				overlay->set_dirty(false);
+		}
+
+		_next_frame_time += get_frame_interval();
+		// After a late frame the schedule restarts from now instead of drawing the missed frames in a burst.
+		if (_next_frame_time < now)
+			_next_frame_time = now + get_frame_interval();
+	}
+
+	void ScreenManager::wait_until(double time)
+	{
+		double remaining = time - glfwGetTime();
+		while (remaining > IONIC_LOOP_SPIN_TIME)
+		{
+			glfwWaitEventsTimeout(remaining - IONIC_LOOP_SPIN_TIME);
+			remaining = time - glfwGetTime();
+		}
+		while (glfwGetTime() < time)
+			std::this_thread::yield();
+		glfwPollEvents();
+	}
+
+	void ScreenManager::check_framebuffer_size(Graphics *graphics)
+	{
+		auto current_size = _window->get_size();
+		if (old_framebuffer_size == current_size)
+			return;
+		_redraw_requested = true;
+		graphics->update_framebuffer_size(current_size.get_width(), current_size.get_height());
+		old_framebuffer_size = current_size;
+		auto screen = get_active_screen();
+		if (screen != nullptr)
+		{
+			screen->refresh(current_size.get_width(), current_size.get_height());
+			screen->init();
+		}
+		for (const auto &active_overlay : _active_overlays)
+		{
+			Overlay *overlay = get_overlay(active_overlay);
+			if (overlay != nullptr)
+			{
+				overlay->refresh(current_size.get_width(), current_size.get_height());
+				overlay->init();
+			}
+		}
+	}
+
 	bool ScreenManager::operator==(const ScreenManager &other) const
 	{
 		return _id == other._id;
@@ -8,22 +8,69 @@
  */
 
 #include "../../include/ionicengine/graphics/shader.h"
+#include "../../include/ionicengine/gl/state.h"
+#include "../../include/ionicengine/profiler.h"
+#include "../../include/ionicengine/tracing.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <map>
+#include <vector>
 
 namespace ionicengine
 {
-	std::map<std::string, Shader> shaders;
+	ResourceStorage<Shader> shaders;
+
+	const UniformLocations EMPTY_UNIFORMS;
+
+	/*!
+	 * Queries the locations of every active uniform of a linked program.
+	 * @param id The OpenGL program ID.
+	 * @return The uniforms locations.
+	 */
+	UniformLocations introspect_uniforms(uint32_t id)
+	{
+		UniformLocations uniforms;
+		GLint count = 0, max_length = 0;
+		glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+		std::vector<char> buffer(static_cast<size_t>(max_length) + 1);
+
+		for (GLint i = 0; i < count; i++)
+		{
+			GLint size;
+			GLenum type;
+			GLsizei length;
+			glGetActiveUniform(id, static_cast<GLuint>(i), max_length, &length, &size, &type, buffer.data());
+			std::string name{buffer.data(), static_cast<size_t>(length)};
+			// Arrays are reported as "name[0]", every element gets its own entry.
+			auto bracket = name.find('[');
+			if (bracket != std::string::npos)
+			{
+				auto base_name = name.substr(0, bracket);
+				for (GLint element = 0; element < size; element++)
+				{
+					auto element_name = base_name + "[" + std::to_string(element) + "]";
+					uniforms[element_name] = glGetUniformLocation(id, element_name.c_str());
+				}
+				uniforms[base_name] = uniforms[base_name + "[0]"];
+			}
+			else
+				uniforms[name] = glGetUniformLocation(id, name.c_str());
+		}
+		return uniforms;
+	}
 
 	Shader::Shader() : _id(0)
 	{}
 
 	Shader::Shader(uint32_t id) : _id(id)
-	{}
+	{
+		if (id != 0)
+			_uniforms = std::make_shared<const UniformLocations>(introspect_uniforms(id));
+	}
 
 	Shader::Shader(const Shader &shader) = default;
 
-	Shader::Shader(Shader &&shader) noexcept : _id(shader._id)
+	Shader::Shader(Shader &&shader) noexcept : _id(shader._id), _uniforms(std::move(shader._uniforms))
 	{}
 
 	uint32_t Shader::get_id() const
@@ -31,32 +78,64 @@ namespace ionicengine
 		return _id;
 	}
 
+	int32_t Shader::get_uniform_location(std::string_view name) const
+	{
+		if (!_uniforms)
+			return -1;
+		auto uniform = _uniforms->find(name);
+		if (uniform == _uniforms->end())
+			return -1;
+		return uniform->second;
+	}
+
+	const UniformLocations &Shader::get_uniform_locations() const
+	{
+		if (!_uniforms)
+			return EMPTY_UNIFORMS;
+		return *_uniforms;
+	}
+
 	Shader &Shader::use()
 	{
 		if (_id != 0)
-			glUseProgram(_id);
+			glstate::use_program(_id);
 		return *this;
 	}
 
 	void Shader::set_float(const std::string &name, float value, bool use_shader)
+	{
+		this->set_float(get_uniform_location(name), value, use_shader);
+	}
+
+	void Shader::set_float(int32_t location, float value, bool use_shader)
 	{
 		if (use_shader)
 			this->use();
-		glUniform1f(glGetUniformLocation(_id, name.c_str()), value);
+		glUniform1f(location, value);
 	}
 
 	void Shader::set_integer(const std::string &name, int value, bool use_shader)
+	{
+		this->set_integer(get_uniform_location(name), value, use_shader);
+	}
+
+	void Shader::set_integer(int32_t location, int value, bool use_shader)
 	{
 		if (use_shader)
 			this->use();
-		glUniform1i(glGetUniformLocation(_id, name.c_str()), value);
+		glUniform1i(location, value);
 	}
 
 	void Shader::set_vector_2f(const std::string &name, float x, float y, bool use_shader)
+	{
+		this->set_vector_2f(get_uniform_location(name), x, y, use_shader);
+	}
+
+	void Shader::set_vector_2f(int32_t location, float x, float y, bool use_shader)
 	{
 		if (use_shader)
 			this->use();
-		glUniform2f(glGetUniformLocation(_id, name.c_str()), x, y);
+		glUniform2f(location, x, y);
 	}
 
 	void Shader::set_vector_2f(const std::string &name, const glm::vec2 &value, bool use_shader)
@@ -64,11 +143,21 @@ namespace ionicengine
 		this->set_vector_2f(name, value.x, value.y, use_shader);
 	}
 
+	void Shader::set_vector_2f(int32_t location, const glm::vec2 &value, bool use_shader)
+	{
+		this->set_vector_2f(location, value.x, value.y, use_shader);
+	}
+
 	void Shader::setVector3f(const std::string &name, float x, float y, float z, bool use_shader)
+	{
+		this->setVector3f(get_uniform_location(name), x, y, z, use_shader);
+	}
+
+	void Shader::setVector3f(int32_t location, float x, float y, float z, bool use_shader)
 	{
 		if (use_shader)
 			this->use();
-		glUniform3f(glGetUniformLocation(_id, name.c_str()), x, y, z);
+		glUniform3f(location, x, y, z);
 	}
 
 	void Shader::setVector3f(const std::string &name, const glm::vec3 &value, bool use_shader)
@@ -76,11 +165,21 @@ namespace ionicengine
 		this->setVector3f(name, value.x, value.y, value.z, use_shader);
 	}
 
+	void Shader::setVector3f(int32_t location, const glm::vec3 &value, bool use_shader)
+	{
+		this->setVector3f(location, value.x, value.y, value.z, use_shader);
+	}
+
 	void Shader::set_vector_4f(const std::string &name, float x, float y, float z, float w, bool use_shader)
+	{
+		this->set_vector_4f(get_uniform_location(name), x, y, z, w, use_shader);
+	}
+
+	void Shader::set_vector_4f(int32_t location, float x, float y, float z, float w, bool use_shader)
 	{
 		if (use_shader)
 			this->use();
-		glUniform4f(glGetUniformLocation(_id, name.c_str()), x, y, z, w);
+		glUniform4f(location, x, y, z, w);
 	}
 
 	void Shader::set_vector_4f(const std::string &name, const glm::vec4 &value, bool use_shader)
@@ -88,6 +187,11 @@ namespace ionicengine
 		this->set_vector_4f(name, value.x, value.y, value.z, value.w, use_shader);
 	}
 
+	void Shader::set_vector_4f(int32_t location, const glm::vec4 &value, bool use_shader)
+	{
+		this->set_vector_4f(location, value.x, value.y, value.z, value.w, use_shader);
+	}
+
 	void Shader::set_color(const lambdacommon::Color &color, bool use_shader)
 	{
 		this->set_color("inColor", color, use_shader);
@@ -99,11 +203,21 @@ namespace ionicengine
 		this->set_vector_4f(name, color.red(), color.green(), color.blue(), color.alpha(), use_shader);
 	}
 
+	void Shader::set_color(int32_t location, const lambdacommon::Color &color, bool use_shader)
+	{
+		this->set_vector_4f(location, color.red(), color.green(), color.blue(), color.alpha(), use_shader);
+	}
+
 	void Shader::set_matrix_4f(const std::string &name, const glm::mat4 &matrix, bool use_shader)
+	{
+		this->set_matrix_4f(get_uniform_location(name), matrix, use_shader);
+	}
+
+	void Shader::set_matrix_4f(int32_t location, const glm::mat4 &matrix, bool use_shader)
 	{
 		if (use_shader)
 			this->use();
-		glUniformMatrix4fv(glGetUniformLocation(_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(matrix));
+		glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
 	}
 
 	Shader::operator bool() const
@@ -116,7 +230,10 @@ namespace ionicengine
 	Shader &Shader::operator=(Shader &&other) noexcept
 	{
 		if (this != &other)
+		{
 			_id = other._id;
+			_uniforms = std::move(other._uniforms);
+		}
 		return *this;
 	}
 
@@ -163,8 +280,12 @@ namespace ionicengine
 
 	std::optional<Shader> IONICENGINE_API shader::compile(const lambdacommon::ResourceName &shader_name)
 	{
-		if (shaders.count(shader_name.to_string()))
-			return {shaders.at(shader_name.to_string())};
+		auto handle = resource::intern(shader_name);
+		if (shaders.has(handle))
+			return {shaders.at(handle)};
+
+		IONIC_PROFILE_SCOPE("shader::compile");
+		IONIC_TRACE_SCOPE("shader::compile");
 
 		auto vertexSource = get_resources_manager().load_resource(shader_name, "vert");
 		auto fragmentSource = get_resources_manager().load_resource(shader_name, "frag");
@@ -213,22 +334,37 @@ namespace ionicengine
 		glDeleteShader(sFragment);
 		if (hasGeomtryShader)
 			glDeleteShader(sGeom);
+		// Introspects the active uniforms once, every copy of the shader shares the locations.
 		Shader shader{id};
 		print_debug("[IonicEngine] Shader '" + shader_name.to_string() + "' loaded successfully with ID '" +
 					std::to_string(id) + "'!");
-		shaders.insert(std::pair<std::string, Shader>(shader_name.to_string(), shader));
+		shaders.set(handle, shader);
 		return {shader};
 	}
 
 	bool shader::hasShader(const lambdacommon::ResourceName &shader_name)
 	{
-		return static_cast<bool>(shaders.count(shader_name.to_string()));
+		return shaders.has(resource::find(shader_name));
+	}
+
+	bool shader::hasShader(ResourceHandle shader)
+	{
+		return shaders.has(shader);
 	}
 
 	const Shader &shader::getShader(const lambdacommon::ResourceName &shader_name)
 	{
-		if (!shaders.count(shader_name.to_string()))
+		auto shader = shaders.find(resource::find(shader_name));
+		if (shader == nullptr)
 			throw std::runtime_error("Cannot get the shader " + shader_name.to_string());
-		return shaders[shader_name.to_string()];
+		return *shader;
+	}
+
+	const Shader &shader::getShader(ResourceHandle shader)
+	{
+		auto stored_shader = shaders.find(shader);
+		if (stored_shader == nullptr)
+			throw std::runtime_error("Cannot get the shader with handle " + std::to_string(shader.get_index()));
+		return *stored_shader;
 	}
 }
\ No newline at end of file
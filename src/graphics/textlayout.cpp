@@ -0,0 +1,192 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../../include/ionicengine/graphics/textlayout.h"
+#include <lambdacommon/maths.h>
+#include <cmath>
+#include <list>
+#include <string_view>
+#include <unordered_map>
+
+namespace maths = lambdacommon::maths;
+
+namespace ionicengine
+{
+	TextLayout::TextLayout(const Font &font, const std::string &text, uint32_t wrap_width) : _font(font),
+																							  _wrap_width(wrap_width)
+	{
+		auto line_height = static_cast<float>(font.get_height());
+		auto space_advance = font.get_advance(font.get_character(' '));
+
+		float x = 0.f, y = 0.f;
+		size_t line_start = 0;
+		// The glyph following the last space of the line and the pen position there.
+		size_t break_glyph = 0;
+		float break_x = 0.f;
+
+		auto new_line = [&](size_t end, float width)
+		{
+			_lines.push_back({line_start, end - line_start, width});
+			_width = maths::max(_width, width);
+			line_start = end;
+			break_glyph = end;
+			y += line_height;
+		};
+
+		size_t offset = 0;
+		while (offset < text.size())
+		{
+			auto codepoint = utf8::decode(text, offset);
+			if (codepoint == '\n')
+			{
+				new_line(_glyphs.size(), x);
+				x = 0.f;
+				continue;
+			}
+
+			float advance = codepoint == '\t' ? space_advance * font.get_tab_size()
+											  : font.get_advance(font.get_character(codepoint));
+			if (wrap_width != 0 && x + advance > wrap_width && _glyphs.size() > line_start)
+			{
+				if (codepoint == ' ')
+				{
+					// The space ending the line is dropped.
+					new_line(_glyphs.size(), x);
+					x = 0.f;
+					continue;
+				}
+				else if (break_glyph > line_start)
+				{
+					// The word being written moves to the next line.
+					auto width = _glyphs[break_glyph - 1].x;
+					new_line(break_glyph, width);
+					for (size_t i = line_start; i < _glyphs.size(); i++)
+					{
+						_glyphs[i].x -= break_x;
+						_glyphs[i].y = y;
+					}
+					x -= break_x;
+				}
+				else
+				{
+					new_line(_glyphs.size(), x);
+					x = 0.f;
+				}
+			}
+
+			_glyphs.push_back({codepoint, x, y});
+			x += advance;
+			if (codepoint == ' ' || codepoint == '\t')
+			{
+				break_glyph = _glyphs.size();
+				break_x = x;
+			}
+		}
+		new_line(_glyphs.size(), x);
+	}
+
+	const Font &TextLayout::get_font() const
+	{
+		return _font;
+	}
+
+	uint32_t TextLayout::get_wrap_width() const
+	{
+		return _wrap_width;
+	}
+
+	const std::vector<LayoutGlyph> &TextLayout::get_glyphs() const
+	{
+		return _glyphs;
+	}
+
+	const std::vector<LayoutLine> &TextLayout::get_lines() const
+	{
+		return _lines;
+	}
+
+	uint32_t TextLayout::get_width() const
+	{
+		return static_cast<uint32_t>(std::lround(_width));
+	}
+
+	uint32_t TextLayout::get_height() const
+	{
+		return static_cast<uint32_t>(_lines.size() * _font.get_height());
+	}
+
+	namespace text_layout
+	{
+		struct CachedLayout
+		{
+			size_t hash;
+			std::string text;
+			std::shared_ptr<const TextLayout> layout;
+		};
+
+		// Most recently used first, the index maps the hash of a key to its entry.
+		static std::list<CachedLayout> layouts;
+		static std::unordered_map<size_t, std::list<CachedLayout>::iterator> layouts_index;
+
+		static size_t hash_key(const Font &font, const std::string &text, uint32_t wrap_width)
+		{
+			auto hash = std::hash<std::string_view>{}(text);
+			auto combine = [&hash](size_t value)
+			{
+				hash ^= value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+			};
+			combine(std::hash<const void *>{}(font.get_data()));
+			combine(font.get_size());
+			combine(font.get_tab_size());
+			combine(wrap_width);
+			return hash;
+		}
+
+		std::shared_ptr<const TextLayout> IONICENGINE_API
+		get(const Font &font, const std::string &text, uint32_t wrap_width)
+		{
+			auto hash = hash_key(font, text, wrap_width);
+			auto entry = layouts_index.find(hash);
+			if (entry != layouts_index.end())
+			{
+				const auto &cached = *entry->second;
+				// A hash collision is handled as a miss, the new layout replaces the old one.
+				if (cached.layout->get_font() == font && cached.layout->get_wrap_width() == wrap_width &&
+					cached.text == text)
+				{
+					layouts.splice(layouts.begin(), layouts, entry->second);
+					return entry->second->layout;
+				}
+				layouts.erase(entry->second);
+				layouts_index.erase(entry);
+			}
+
+			auto layout = std::make_shared<const TextLayout>(font, text, wrap_width);
+			layouts.push_front({hash, text, layout});
+			layouts_index[hash] = layouts.begin();
+			if (layouts.size() > IONIC_TEXT_LAYOUT_CACHE_SIZE)
+			{
+				layouts_index.erase(layouts.back().hash);
+				layouts.pop_back();
+			}
+			return layout;
+		}
+
+		size_t IONICENGINE_API get_cache_size()
+		{
+			return layouts.size();
+		}
+
+		void IONICENGINE_API clear_cache()
+		{
+			layouts_index.clear();
+			layouts.clear();
+		}
+	}
+}
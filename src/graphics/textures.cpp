@@ -9,10 +9,17 @@
 
 #include "../../include/ionicengine/graphics/textures.h"
 #include "../../include/ionicengine/ionicengine.h"
+#include "../../include/ionicengine/gl/state.h"
+#include "../../include/ionicengine/threadpool.h"
+#include "../../include/ionicengine/profiler.h"
+#include "../../include/ionicengine/tracing.h"
+#include "../../include/ionicengine/graphics/cookedtexture.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 
 #include <stb_image.h>
+#include <chrono>
+#include <cstring>
 #include <stdexcept>
 
 namespace ionicengine
@@ -114,8 +121,7 @@ namespace ionicengine
 
 	void Texture::bind(uint32_t texture_unit) const
 	{
-		glActiveTexture(texture_unit);
-		glBindTexture(GL_TEXTURE_2D, _id);
+		glstate::bind_texture(texture_unit, _id);
 	}
 
 	void Texture::unbind() const
@@ -128,6 +134,7 @@ namespace ionicengine
 		unbind();
 		GLuint textures[] = {static_cast<GLuint>(_id)};
 		glDeleteTextures(1, textures);
+		glstate::forget_texture(_id);
 		_id = 0;
 	}
 
@@ -148,20 +155,208 @@ namespace ionicengine
 
 	namespace texture
 	{
-		std::map<lambdacommon::ResourceName, Texture> textures;
+		ResourceStorage<Texture> textures;
+
+		/*!
+		 * An asynchronous load, decoded by a worker then uploaded by the main thread.
+		 */
+		struct TextureUpload
+		{
+			ResourceHandle handle;
+			std::string path;
+			TextureWrapMode wrap_mode;
+			TextureFilterMode filter_mode;
+			bool use_mipmap;
+			std::promise<std::optional<Texture>> promise;
+			// Written by the worker before the upload is queued.
+			unsigned char *pixels = nullptr;
+			uint32_t width = 0, height = 0, channels = 0;
+			// Upload progress, only touched by the main thread.
+			uint32_t id = 0, uploaded_rows = 0;
+		};
+
+		std::mutex decoded_uploads_mutex;
+		std::deque<std::shared_ptr<TextureUpload>> decoded_uploads;
+		// Main thread only.
+		std::shared_ptr<TextureUpload> current_upload;
+		ResourceStorage<TextureFuture> pending_loads;
+		uint32_t upload_pbo = 0;
+
+		void apply_parameters(TextureWrapMode wrap_mode, TextureFilterMode filter_mode)
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_mode);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_mode);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_mode);
+			// Magnification doesn't use mipmaps.
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+							filter_mode == NEAREST || filter_mode == NEAREST_MIPMAP_NEAREST ||
+							filter_mode == NEAREST_MIPMAP_LINEAR ? NEAREST : LINEAR);
+		}
+
+		TextureFuture ready_future(std::optional<Texture> texture)
+		{
+			std::promise<std::optional<Texture>> promise;
+			promise.set_value(texture);
+			return promise.get_future().share();
+		}
+
+		/*!
+		 * Uploads the next rows of the current upload through the pixel buffer.
+		 */
+		void upload_chunk(TextureUpload &upload)
+		{
+			size_t row_size = static_cast<size_t>(upload.width) * 4;
+			auto rows = static_cast<uint32_t>(std::max<size_t>(1, IONIC_TEXTURE_UPLOAD_CHUNK_SIZE / row_size));
+			rows = std::min(rows, upload.height - upload.uploaded_rows);
+			size_t size = rows * row_size;
+			auto source = upload.pixels + upload.uploaded_rows * row_size;
+
+			// Orphans the previous storage, the driver may still be reading it for the last chunk.
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+			auto destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+												GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+			if (destination != nullptr)
+			{
+				std::memcpy(destination, source, size);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			}
+			else
+				glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, source);
+
+			bind(upload.id);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, upload.uploaded_rows, upload.width, rows, GL_RGBA, GL_UNSIGNED_BYTE,
+							nullptr);
+			upload.uploaded_rows += rows;
+		}
+
+		void finish_upload(TextureUpload &upload)
+		{
+			stbi_image_free(upload.pixels);
+			upload.pixels = nullptr;
+
+			Texture texture{upload.id, upload.width, upload.height, upload.channels};
+			// A synchronous load of the same texture may have completed meanwhile.
+			if (auto existing = textures.find(upload.handle))
+			{
+				texture.delete_texture();
+				texture = *existing;
+			}
+			else
+			{
+				textures.set(upload.handle, texture);
+				print_debug("[IonicEngine] Texture '" + resource::get_name(upload.handle).to_string() +
+							"' loaded asynchronously with ID '" + std::to_string(upload.id) + "'!");
+			}
+			pending_loads.erase(upload.handle);
+			upload.promise.set_value(texture);
+		}
+
+		void cancel_upload(TextureUpload &upload)
+		{
+			if (upload.pixels != nullptr)
+				stbi_image_free(upload.pixels);
+			upload.pixels = nullptr;
+			if (upload.id != 0)
+				Texture{upload.id, upload.width, upload.height, upload.channels}.delete_texture();
+			pending_loads.erase(upload.handle);
+			upload.promise.set_value(std::nullopt);
+		}
+
+		Texture register_texture(const lambdacommon::ResourceName &name, uint32_t id, uint32_t width, uint32_t height,
+								 uint32_t channels)
+		{
+			Texture texture{id, width, height, channels};
+
+			auto handle = resource::intern(name);
+			if (!textures.has(handle))
+				textures.set(handle, texture);
+
+			print_debug("[IonicEngine] Texture '" + name.to_string() + "' loaded successfully with ID '" +
+						std::to_string(id) + "'!");
+
+			return texture;
+		}
+
+		/*!
+		 * Uploads the cooked texture of the specified resource, straight from its memory mapping.
+		 * @param name The resource name of the texture.
+		 * @param cooked_extension The extension of the cooked texture.
+		 * @param source_path The path of the source image, the cooked texture is ignored if the source changed.
+		 * @return The texture, or nothing if the cooked texture is missing, stale or uses an unsupported compression.
+		 */
+		std::optional<Texture>
+		load_cooked(const lambdacommon::ResourceName &name, const std::string &cooked_extension,
+					const std::string &source_path, TextureWrapMode wrap_mode, TextureFilterMode filter_mode,
+					bool use_mipmap)
+		{
+			CookedTexture cooked;
+			if (!cooked.open(get_resources_manager().get_resource_path(name, cooked_extension).to_string()))
+				return std::nullopt;
+			if (!cooked.is_up_to_date(source_path))
+			{
+				print_debug("[IonicEngine] The cooked texture '" + name.to_string() + "' is outdated, using the source.");
+				return std::nullopt;
+			}
+
+			const auto &header = cooked.get_header();
+			GLenum compressed_format = 0;
+			if (header.format == COOKED_BC1)
+				compressed_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+			else if (header.format == COOKED_BC3)
+				compressed_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			if (compressed_format != 0 && !GLEW_EXT_texture_compression_s3tc)
+				return std::nullopt;
+
+			uint32_t levels = use_mipmap ? header.mip_count : 1;
+			uint32_t id;
+			glGenTextures(1, &id);
+			bind(id);
+			apply_parameters(wrap_mode, filter_mode);
+			for (uint32_t level = 0; level < levels; level++)
+			{
+				const auto &mip = cooked.get_level(level);
+				if (compressed_format != 0)
+					glCompressedTexImage2D(GL_TEXTURE_2D, level, compressed_format, mip.width, mip.height, 0,
+										   static_cast<GLsizei>(mip.size), cooked.get_level_data(level));
+				else
+					glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+								 cooked.get_level_data(level));
+			}
+			if (use_mipmap && levels == 1 && compressed_format == 0)
+				glGenerateMipmap(GL_TEXTURE_2D);
+			else
+				// Keeps the texture complete with only the cooked levels.
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels - 1));
+			unbind();
+
+			return register_texture(name, id, header.width, header.height, header.channels);
+		}
 
 		std::optional<Texture> IONICENGINE_API
 		load(const lambdacommon::ResourceName &name, const std::string &extension, TextureWrapMode wrap_mode,
 			 TextureFilterMode filter_mode, bool use_mipmap)
 		{
+			IONIC_PROFILE_SCOPE("texture::load");
+			IONIC_TRACE_SCOPE("texture::load");
+			auto source_path = get_resources_manager().get_resource_path(name, extension).to_string();
+			// A cooked texture next to the source skips the decoding and the mipmaps generation.
+			auto cooked_extension = get_cooked_extension(extension);
+			if (get_resources_manager().does_resource_exist(name, cooked_extension))
+			{
+				auto texture = load_cooked(name, cooked_extension,
+										   extension == IONIC_COOKED_TEXTURE_EXTENSION ? "" : source_path, wrap_mode,
+										   filter_mode, use_mipmap);
+				if (texture || extension == IONIC_COOKED_TEXTURE_EXTENSION)
+					return texture;
+			}
+
 			if (!get_resources_manager().does_resource_exist(name, extension))
 				return std::nullopt;
 
 			//stbi_set_flip_vertically_on_load(true);
 
 			int width, height, channels;
-			auto image = stbi_load(get_resources_manager().get_resource_path(name, extension).to_string().c_str(), &width,
-								   &height, &channels, 4);
+			auto image = stbi_load(source_path.c_str(), &width, &height, &channels, 4);
 			if (!image)
 				return {};
 			auto texture = create(name, image, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
@@ -170,18 +365,139 @@ namespace ionicengine
 			return texture;
 		}
 
+		TextureFuture IONICENGINE_API
+		load_async(const lambdacommon::ResourceName &name, const std::string &extension, TextureWrapMode wrap_mode,
+				   TextureFilterMode filter_mode, bool use_mipmap)
+		{
+			auto handle = resource::intern(name);
+			if (auto texture = textures.find(handle))
+				return ready_future(*texture);
+			if (auto pending = pending_loads.find(handle))
+				return *pending;
+			if (!get_resources_manager().does_resource_exist(name, extension))
+				return ready_future(std::nullopt);
+
+			auto upload = std::make_shared<TextureUpload>();
+			upload->handle = handle;
+			upload->path = get_resources_manager().get_resource_path(name, extension).to_string();
+			upload->wrap_mode = wrap_mode;
+			upload->filter_mode = filter_mode;
+			upload->use_mipmap = use_mipmap;
+			auto future = upload->promise.get_future().share();
+			pending_loads.set(handle, future);
+
+			get_worker_pool().submit([upload]()
+									 {
+										 int width, height, channels;
+										 upload->pixels = stbi_load(upload->path.c_str(), &width, &height,
+																	&channels, 4);
+										 if (upload->pixels != nullptr)
+										 {
+											 upload->width = static_cast<uint32_t>(width);
+											 upload->height = static_cast<uint32_t>(height);
+											 upload->channels = static_cast<uint32_t>(channels);
+										 }
+										 std::lock_guard<std::mutex> lock{decoded_uploads_mutex};
+										 decoded_uploads.push_back(upload);
+									 });
+			return future;
+		}
+
+		bool IONICENGINE_API process_uploads(double budget_ms)
+		{
+			auto deadline = std::chrono::steady_clock::now() +
+							std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+									std::chrono::duration<double, std::milli>(budget_ms));
+			bool pbo_bound = false;
+
+			while (true)
+			{
+				if (!current_upload)
+				{
+					std::lock_guard<std::mutex> lock{decoded_uploads_mutex};
+					if (decoded_uploads.empty())
+						break;
+					current_upload = decoded_uploads.front();
+					decoded_uploads.pop_front();
+				}
+
+				auto &upload = *current_upload;
+				if (upload.pixels == nullptr)
+				{
+					print_error("[IonicEngine] Cannot decode the texture '" + upload.path + "'.");
+					cancel_upload(upload);
+					current_upload.reset();
+					continue;
+				}
+
+				if (upload.id == 0)
+				{
+					glGenTextures(1, &upload.id);
+					bind(upload.id);
+					apply_parameters(upload.wrap_mode, upload.filter_mode);
+					// With a pixel unpack buffer bound the null pixels would be read as an offset into it.
+					if (pbo_bound)
+					{
+						glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+						pbo_bound = false;
+					}
+					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, upload.width, upload.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+								 nullptr);
+				}
+
+				if (upload.uploaded_rows < upload.height)
+				{
+					if (!pbo_bound)
+					{
+						if (upload_pbo == 0)
+							glGenBuffers(1, &upload_pbo);
+						glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload_pbo);
+						pbo_bound = true;
+					}
+					upload_chunk(upload);
+					// Generating the mipmaps may cost as much as the whole upload, it is the first step of the next
+					// call instead of running past the budget of this one.
+					if (upload.uploaded_rows == upload.height && upload.use_mipmap)
+						break;
+				}
+				else
+				{
+					bind(upload.id);
+					glGenerateMipmap(GL_TEXTURE_2D);
+				}
+
+				if (upload.uploaded_rows == upload.height)
+				{
+					finish_upload(upload);
+					current_upload.reset();
+				}
+
+				// Written with < only, >= is ambiguous with std::rel_ops in scope.
+				if (!(std::chrono::steady_clock::now() < deadline))
+					break;
+			}
+
+			// A bound unpack buffer would turn the pixel pointers of the other uploads into offsets.
+			if (pbo_bound)
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			return get_pending_loads() != 0;
+		}
+
+		size_t IONICENGINE_API get_pending_loads()
+		{
+			return pending_loads.size();
+		}
+
 		Texture IONICENGINE_API
 		create(const lambdacommon::ResourceName &name, unsigned char *image, uint32_t width, uint32_t height,
 			   uint32_t channels, TextureWrapMode wrap_mode, TextureFilterMode filter_mode, bool use_mipmap)
 		{
 			uint32_t id;
 			glGenTextures(1, &id);
-			glBindTexture(GL_TEXTURE_2D, id);
+			bind(id);
 			// Set texture options
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_mode);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_mode);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_mode);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mode);
+			apply_parameters(wrap_mode, filter_mode);
 
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
 			if (use_mipmap)
@@ -189,24 +505,32 @@ namespace ionicengine
 
 			unbind();
 
-			Texture texture{id, width, height, channels};
-
-			textures.insert({name, texture});
+			return register_texture(name, id, width, height, channels);
+		}
 
-			print_debug("[IonicEngine] Texture '" + name.to_string() + "' loaded successfully with ID '" +
-						std::to_string(id) + "'!");
+		Texture IONICENGINE_API get_texture(const lambdacommon::ResourceName &name)
+		{
+			return textures.at(resource::find(name));
+		}
 
-			return texture;
+		Texture IONICENGINE_API get_texture(ResourceHandle handle)
+		{
+			return textures.at(handle);
 		}
 
-		Texture IONICENGINE_API get_texture(const lambdacommon::ResourceName &name)
+		const Texture *IONICENGINE_API find_texture(ResourceHandle handle)
 		{
-			return textures.at(name);
+			return textures.find(handle);
 		}
 
 		bool IONICENGINE_API has_texture(const lambdacommon::ResourceName &name)
 		{
-			return textures.count(name);
+			return textures.has(resource::find(name));
+		}
+
+		bool IONICENGINE_API has_texture(ResourceHandle handle)
+		{
+			return textures.has(handle);
 		}
 
 		TextureRegion IONICENGINE_API
@@ -219,14 +543,21 @@ namespace ionicengine
 
 		void IONICENGINE_API delete_texture(const lambdacommon::ResourceName &name)
 		{
-			if (!has_texture(name))
+			delete_texture(resource::find(name));
+		}
+
+		void IONICENGINE_API delete_texture(ResourceHandle handle)
+		{
+			auto texture = textures.find(handle);
+			if (texture == nullptr)
 				return;
-			get_texture(name).delete_texture();
+			texture->delete_texture();
+			textures.erase(handle);
 		}
 
 		void IONICENGINE_API bind(uint32_t id)
 		{
-			glBindTexture(GL_TEXTURE_2D, id);
+			glstate::bind_texture(id);
 		}
 
 		void IONICENGINE_API unbind()
@@ -236,10 +567,28 @@ namespace ionicengine
 
 		void IONICENGINE_API shutdown()
 		{
-			for(auto const& [key, val] : textures)
+			if (current_upload)
+			{
+				cancel_upload(*current_upload);
+				current_upload.reset();
+			}
 			{
-				delete_texture(key);
+				std::lock_guard<std::mutex> lock{decoded_uploads_mutex};
+				for (auto &upload : decoded_uploads)
+					cancel_upload(*upload);
+				decoded_uploads.clear();
 			}
+			if (upload_pbo != 0)
+			{
+				glDeleteBuffers(1, &upload_pbo);
+				upload_pbo = 0;
+			}
+
+			textures.for_each([](ResourceHandle, Texture &texture)
+							  {
+								  texture.delete_texture();
+							  });
+			textures.clear();
 		}
 	}
 }
\ No newline at end of file
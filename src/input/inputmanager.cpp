@@ -9,6 +9,7 @@
 
 #include "../../include/ionicengine/input/inputmanager.h"
 #include "../../include/ionicengine/graphics/screen.h"
+#include "../../include/ionicengine/tracing.h"
 #include <lambdacommon/system/time.h>
 #include <algorithm>
 #include <stdexcept>
@@ -105,6 +106,7 @@ namespace ionicengine
 
 	void update_controllers()
 	{
+		tracing::set_thread_name("Controllers");
 		time_t start_time = lambdacommon::time::get_time_millis();
 		for (bool &j : triggers_as_button)
 			j = true;
@@ -113,6 +115,7 @@ namespace ionicengine
 			time_t current_time = lambdacommon::time::get_time_millis() - start_time;
 			if (current_time >= 50)
 			{
+				IONIC_TRACE_SCOPE("InputManager::poll_controllers");
 				// Update
 				if (!InputManager::INPUT_MANAGER.get_controller_input_listeners().empty())
 					for (Controller *controller : InputManager::INPUT_MANAGER.get_controllers())
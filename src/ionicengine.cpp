@@ -10,15 +10,17 @@
 #include "../include/ionicengine/ionicengine.h"
 #include "../include/ionicengine/input/inputmanager.h"
 #include "../include/ionicengine/graphics/screen.h"
+#include "../include/ionicengine/threadpool.h"
 
-#include <algorithm>
 #include <iostream>
+#include <memory>
 
 namespace ionicengine
 {
 	lambdacommon::ResourcesManager manager;
 	FontManager *font_manager = nullptr;
-	std::vector<ScreenManager> *windows = nullptr;
+	// Held by pointer, a ScreenManager owns its render thread state and cannot be copied.
+	std::vector<std::unique_ptr<ScreenManager>> *windows = nullptr;
 	bool initialized = false;
 	bool running = false;
 	bool _debug = false;
@@ -41,6 +43,8 @@ namespace ionicengine
 	{
 		initialized = false;
 		print_debug("[IonicEngine] Shutting down...");
+		// The loaders must be done before the resources they fill are released.
+		shutdown_worker_pool();
 		window::destroy_all();
 		sound::shutdown();
 		font_manager->shutdown();
@@ -73,21 +77,22 @@ namespace ionicengine
 			if (windows->empty())
 				stop();
 			else
-				for (const ScreenManager &screen_manager : *windows)
+				for (auto it = windows->begin(); it != windows->end();)
 				{
-					auto window = screen_manager.get_attached_window();
+					auto window = (*it)->get_attached_window();
 					if (!window || window->should_close())
 					{
 						if (window)
 							window->destroy();
 
-						windows->erase(std::remove(windows->begin(), windows->end(), screen_manager), windows->end());
+						it = windows->erase(it);
 						continue;
 					}
 
 					window->request_context();
 
 					glfwSwapBuffers(window->get_handle());
+					it++;
 				}
 
 			glfwPollEvents();
@@ -0,0 +1,144 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../include/ionicengine/mappedfile.h"
+#include <utility>
+
+#ifdef LAMBDA_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ionicengine
+{
+	MappedFile::MappedFile() = default;
+
+	MappedFile::MappedFile(const std::string &path)
+	{
+		open(path);
+	}
+
+	MappedFile::MappedFile(MappedFile &&other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::open(const std::string &path)
+	{
+		close();
+#ifdef LAMBDA_WINDOWS
+		_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+							FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (_file == INVALID_HANDLE_VALUE)
+		{
+			_file = nullptr;
+			return false;
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+		{
+			close();
+			return false;
+		}
+		_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (_mapping == nullptr)
+		{
+			close();
+			return false;
+		}
+		_data = static_cast<const unsigned char *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (_data == nullptr)
+		{
+			close();
+			return false;
+		}
+		_size = static_cast<size_t>(size.QuadPart);
+#else
+		_file = ::open(path.c_str(), O_RDONLY);
+		if (_file < 0)
+			return false;
+		struct stat status{};
+		if (fstat(_file, &status) != 0 || status.st_size == 0)
+		{
+			close();
+			return false;
+		}
+		auto data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+		if (data == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+		_data = static_cast<const unsigned char *>(data);
+		_size = static_cast<size_t>(status.st_size);
+#endif
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+#ifdef LAMBDA_WINDOWS
+		if (_data != nullptr)
+			UnmapViewOfFile(_data);
+		if (_mapping != nullptr)
+			CloseHandle(_mapping);
+		if (_file != nullptr)
+			CloseHandle(_file);
+		_mapping = nullptr;
+		_file = nullptr;
+#else
+		if (_data != nullptr)
+			munmap(const_cast<unsigned char *>(_data), _size);
+		if (_file >= 0)
+			::close(_file);
+		_file = -1;
+#endif
+		_data = nullptr;
+		_size = 0;
+	}
+
+	const unsigned char *MappedFile::get_data() const
+	{
+		return _data;
+	}
+
+	size_t MappedFile::get_size() const
+	{
+		return _size;
+	}
+
+	MappedFile::operator bool() const
+	{
+		return _data != nullptr;
+	}
+
+	MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+	{
+		if (this != &other)
+		{
+			close();
+			std::swap(_data, other._data);
+			std::swap(_size, other._size);
+			std::swap(_file, other._file);
+#ifdef LAMBDA_WINDOWS
+			std::swap(_mapping, other._mapping);
+#endif
+		}
+		return *this;
+	}
+}
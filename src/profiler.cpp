@@ -0,0 +1,237 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../include/ionicengine/profiler.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace ionicengine
+{
+	namespace profiler
+	{
+		typedef std::chrono::steady_clock clock;
+
+		struct OpenScope
+		{
+			int32_t sample;
+			clock::time_point start;
+			// The index of the begin query in the query slot, -1 for a CPU only scope.
+			int32_t query;
+		};
+
+		struct GpuScope
+		{
+			int32_t sample;
+			// The indices of the begin and end queries in the query slot.
+			size_t begin, end;
+		};
+
+		/*!
+		 * The timestamp queries of one frame, reused every {@code IONIC_PROFILER_QUERY_LATENCY} frames.
+		 */
+		struct QuerySlot
+		{
+			uint64_t frame;
+			std::vector<uint32_t> queries;
+			size_t used = 0;
+			std::vector<GpuScope> scopes;
+		};
+
+		std::atomic<bool> enabled{false};
+		std::thread::id profiled_thread;
+		ProfileFrame current{0, 0.0, {}, false};
+		clock::time_point frame_start;
+		std::vector<OpenScope> open_scopes;
+		std::array<QuerySlot, IONIC_PROFILER_QUERY_LATENCY> query_slots;
+		std::deque<ProfileFrame> history;
+
+		inline bool is_profiled_thread()
+		{
+			return enabled.load(std::memory_order_relaxed) && std::this_thread::get_id() == profiled_thread;
+		}
+
+		uint32_t next_query(QuerySlot &slot)
+		{
+			if (slot.used == slot.queries.size())
+			{
+				uint32_t query;
+				glGenQueries(1, &query);
+				slot.queries.push_back(query);
+			}
+			return slot.queries[slot.used++];
+		}
+
+		/*!
+		 * Reads the GPU times of the frame which used the slot, if the GPU is done with them.
+		 */
+		void resolve(QuerySlot &slot)
+		{
+			if (slot.scopes.empty())
+				return;
+
+			ProfileFrame *frame = nullptr;
+			for (auto &past : history)
+				if (past.index == slot.frame)
+					frame = &past;
+			if (frame != nullptr)
+			{
+				// The queries complete in order, the last one being available means every one is.
+				GLint available = GL_FALSE;
+				glGetQueryObjectiv(slot.queries[slot.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+				if (available == GL_TRUE)
+				{
+					for (const auto &scope : slot.scopes)
+					{
+						GLuint64 begin, end;
+						glGetQueryObjectui64v(slot.queries[scope.begin], GL_QUERY_RESULT, &begin);
+						glGetQueryObjectui64v(slot.queries[scope.end], GL_QUERY_RESULT, &end);
+						auto &sample = frame->samples[scope.sample];
+						sample.gpu_ms = (sample.gpu_ms < 0.0 ? 0.0 : sample.gpu_ms) + (end - begin) / 1000000.0;
+					}
+				}
+				frame->gpu_resolved = true;
+			}
+			slot.scopes.clear();
+			slot.used = 0;
+		}
+
+		void release_queries()
+		{
+			for (auto &slot : query_slots)
+			{
+				if (!slot.queries.empty())
+					glDeleteQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+				slot.queries.clear();
+				slot.scopes.clear();
+				slot.used = 0;
+			}
+		}
+
+		bool IONICENGINE_API is_enabled()
+		{
+			return enabled;
+		}
+
+		void IONICENGINE_API set_enabled(bool enabled)
+		{
+			if (!enabled && profiler::enabled)
+			{
+				release_queries();
+				history.clear();
+			}
+			profiled_thread = std::this_thread::get_id();
+			current = {0, 0.0, {}, false};
+			open_scopes.clear();
+			frame_start = clock::now();
+			profiler::enabled = enabled;
+		}
+
+		void IONICENGINE_API new_frame()
+		{
+			if (!is_profiled_thread())
+				return;
+
+			auto now = clock::now();
+			// A scope left open by the frame is closed with it.
+			while (!open_scopes.empty())
+				end_scope();
+
+			current.frame_ms = std::chrono::duration<double, std::milli>(now - frame_start).count();
+			current.gpu_resolved = query_slots[current.index % IONIC_PROFILER_QUERY_LATENCY].scopes.empty();
+			history.push_back(std::move(current));
+			if (history.size() > IONIC_PROFILER_HISTORY)
+				history.pop_front();
+
+			current = {history.back().index + 1, 0.0, {}, false};
+			frame_start = now;
+
+			// The slot of the new frame was last used IONIC_PROFILER_QUERY_LATENCY frames ago.
+			auto &slot = query_slots[current.index % IONIC_PROFILER_QUERY_LATENCY];
+			resolve(slot);
+			slot.frame = current.index;
+		}
+
+		bool IONICENGINE_API begin_scope(const char *name, bool gpu)
+		{
+			if (!is_profiled_thread())
+				return false;
+
+			int32_t parent = open_scopes.empty() ? -1 : open_scopes.back().sample;
+			int32_t sample = -1;
+			for (size_t i = parent + 1; i < current.samples.size(); i++)
+			{
+				const auto &candidate = current.samples[i];
+				if (candidate.parent == parent && std::strcmp(candidate.name, name) == 0)
+				{
+					sample = static_cast<int32_t>(i);
+					break;
+				}
+			}
+			if (sample == -1)
+			{
+				sample = static_cast<int32_t>(current.samples.size());
+				current.samples.push_back({name, parent, static_cast<uint32_t>(open_scopes.size()), 0, 0.0, -1.0});
+			}
+			current.samples[sample].calls++;
+
+			int32_t query = -1;
+			if (gpu)
+			{
+				auto &slot = query_slots[current.index % IONIC_PROFILER_QUERY_LATENCY];
+				query = static_cast<int32_t>(slot.used);
+				glQueryCounter(next_query(slot), GL_TIMESTAMP);
+			}
+			open_scopes.push_back({sample, clock::now(), query});
+			return true;
+		}
+
+		void IONICENGINE_API end_scope()
+		{
+			if (!is_profiled_thread() || open_scopes.empty())
+				return;
+
+			auto scope = open_scopes.back();
+			open_scopes.pop_back();
+			current.samples[scope.sample].cpu_ms += std::chrono::duration<double, std::milli>(
+					clock::now() - scope.start).count();
+			if (scope.query >= 0)
+			{
+				auto &slot = query_slots[current.index % IONIC_PROFILER_QUERY_LATENCY];
+				size_t end = slot.used;
+				glQueryCounter(next_query(slot), GL_TIMESTAMP);
+				slot.scopes.push_back({scope.sample, static_cast<size_t>(scope.query), end});
+			}
+		}
+
+		const std::deque<ProfileFrame> &IONICENGINE_API get_history()
+		{
+			return history;
+		}
+
+		const ProfileFrame *IONICENGINE_API get_resolved_frame()
+		{
+			for (auto frame = history.rbegin(); frame != history.rend(); ++frame)
+				if (frame->gpu_resolved)
+					return &*frame;
+			return nullptr;
+		}
+
+		ProfileScope::ProfileScope(const char *name, bool gpu) : _active(begin_scope(name, gpu))
+		{}
+
+		ProfileScope::~ProfileScope()
+		{
+			if (_active)
+				end_scope();
+		}
+	}
+}
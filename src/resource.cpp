@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../include/ionicengine/resource.h"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace ionicengine
+{
+	namespace resource
+	{
+		struct ResourceNameHash
+		{
+			size_t operator()(const lambdacommon::ResourceName &name) const
+			{
+				std::hash<std::string> hash;
+				return hash(name.get_domain()) * 31 + hash(name.get_name());
+			}
+		};
+
+		// Resources may be interned from loader threads, the lookups only share the lock.
+		std::shared_mutex intern_mutex;
+		std::unordered_map<lambdacommon::ResourceName, uint32_t, ResourceNameHash> handles;
+		std::deque<lambdacommon::ResourceName> names;
+
+		ResourceHandle IONICENGINE_API intern(const lambdacommon::ResourceName &name)
+		{
+			{
+				std::shared_lock<std::shared_mutex> lock{intern_mutex};
+				auto handle = handles.find(name);
+				if (handle != handles.end())
+					return ResourceHandle{handle->second};
+			}
+			std::lock_guard<std::shared_mutex> lock{intern_mutex};
+			auto handle = handles.find(name);
+			if (handle != handles.end())
+				return ResourceHandle{handle->second};
+			auto index = static_cast<uint32_t>(names.size());
+			names.push_back(name);
+			handles.insert({name, index});
+			return ResourceHandle{index};
+		}
+
+		ResourceHandle IONICENGINE_API find(const lambdacommon::ResourceName &name)
+		{
+			std::shared_lock<std::shared_mutex> lock{intern_mutex};
+			auto handle = handles.find(name);
+			if (handle == handles.end())
+				return {};
+			return ResourceHandle{handle->second};
+		}
+
+		lambdacommon::ResourceName IONICENGINE_API get_name(ResourceHandle handle)
+		{
+			std::shared_lock<std::shared_mutex> lock{intern_mutex};
+			if (handle.get_index() >= names.size())
+				throw std::out_of_range("Unknown resource handle " + std::to_string(handle.get_index()));
+			return names[handle.get_index()];
+		}
+
+		size_t IONICENGINE_API count()
+		{
+			std::shared_lock<std::shared_mutex> lock{intern_mutex};
+			return names.size();
+		}
+	}
+}
@@ -17,7 +17,7 @@ namespace ionicengine
 	{
 		bool running = false;
 
-		std::map<lambdacommon::ResourceName, int> index_buffer;
+		ResourceStorage<int> index_buffer;
 
 		static ALCdevice *device;
 		static ALCcontext *context;
@@ -103,28 +103,47 @@ namespace ionicengine
 
 		void IONICENGINE_API add_sound_index(const lambdacommon::ResourceName &sound, int index)
 		{
-			if (has_sound(sound) && get_sound_index(sound) == index)
+			auto handle = resource::intern(sound);
+			if (has_sound(handle) && get_sound_index(handle) == index)
 				throw std::runtime_error("Cannot add sound that was already indexed.");
-			index_buffer.insert({sound, index});
+			if (!has_sound(handle))
+				index_buffer.set(handle, index);
 		}
 
 		int IONICENGINE_API get_sound_index(const lambdacommon::ResourceName &sound)
 		{
-			if (!has_sound(sound))
+			return get_sound_index(resource::find(sound));
+		}
+
+		int IONICENGINE_API get_sound_index(ResourceHandle sound)
+		{
+			auto index = index_buffer.find(sound);
+			if (index == nullptr)
 				return -1;
-			return index_buffer.at(sound);
+			return *index;
 		}
 
 		bool IONICENGINE_API has_sound(const lambdacommon::ResourceName &sound)
 		{
-			return index_buffer.count(sound);
+			return has_sound(resource::find(sound));
+		}
+
+		bool IONICENGINE_API has_sound(ResourceHandle sound)
+		{
+			return index_buffer.has(sound);
 		}
 
 		int IONICENGINE_API play(const lambdacommon::ResourceName &sound, bool loop)
 		{
-			if (has_sound(sound))
-				return play(get_sound_index(sound), loop);
-			return -1;
+			return play(resource::find(sound), loop);
+		}
+
+		int IONICENGINE_API play(ResourceHandle sound, bool loop)
+		{
+			auto index = get_sound_index(sound);
+			if (index < 0)
+				return -1;
+			return play(index, loop);
 		}
 
 		int IONICENGINE_API play(int buffer, bool loop)
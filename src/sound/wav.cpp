@@ -9,6 +9,8 @@
 
 #include "../../include/ionicengine/sound/wav.h"
 #include "../../include/ionicengine/ionicengine.h"
+#include "../../include/ionicengine/profiler.h"
+#include "../../include/ionicengine/tracing.h"
 #include <al.h>
 #include <sndfile.h>
 
@@ -25,6 +27,8 @@ namespace ionicengine
 
 			int IONICENGINE_API load(const lambdacommon::ResourceName &name, const lambdacommon::fs::FilePath &path)
 			{
+				IONIC_PROFILE_SCOPE("sound::wav::load");
+				IONIC_TRACE_SCOPE("sound::wav::load");
 				if (get_next_free_buffer(false)  < IONIC_SOUND_MAX_BUFFERS)
 				{
 					if (!path.exists())
@@ -0,0 +1,109 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../include/ionicengine/threadpool.h"
+#include "../include/ionicengine/tracing.h"
+
+namespace ionicengine
+{
+	ThreadPool::ThreadPool(size_t threads)
+	{
+		if (threads == 0)
+		{
+			// Leaves one hardware thread to the main thread.
+			auto hardware_threads = std::thread::hardware_concurrency();
+			threads = hardware_threads > 1 ? hardware_threads - 1 : 1;
+		}
+		for (size_t i = 0; i < threads; i++)
+			_workers.emplace_back(&ThreadPool::work, this);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		shutdown();
+	}
+
+	size_t ThreadPool::get_thread_count() const
+	{
+		return _workers.size();
+	}
+
+	size_t ThreadPool::get_queued_tasks() const
+	{
+		std::lock_guard<std::mutex> lock{_mutex};
+		return _tasks.size();
+	}
+
+	void ThreadPool::enqueue(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock{_mutex};
+			if (!_stopping)
+			{
+				_tasks.push_back(std::move(task));
+				_condition.notify_one();
+				return;
+			}
+		}
+		task();
+	}
+
+	void ThreadPool::work()
+	{
+		tracing::set_thread_name("Worker");
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock{_mutex};
+				_condition.wait(lock, [this]()
+				{
+					return _stopping || !_tasks.empty();
+				});
+				if (_tasks.empty())
+					return;
+				task = std::move(_tasks.front());
+				_tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+	void ThreadPool::shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock{_mutex};
+			if (_stopping)
+				return;
+			_stopping = true;
+		}
+		_condition.notify_all();
+		for (auto &worker : _workers)
+			if (worker.joinable())
+				worker.join();
+	}
+
+	std::once_flag worker_pool_flag;
+	std::unique_ptr<ThreadPool> worker_pool;
+
+	ThreadPool &IONICENGINE_API get_worker_pool()
+	{
+		std::call_once(worker_pool_flag, []()
+		{
+			worker_pool = std::make_unique<ThreadPool>();
+		});
+		return *worker_pool;
+	}
+
+	void IONICENGINE_API shutdown_worker_pool()
+	{
+		if (worker_pool)
+			worker_pool->shutdown();
+	}
+}
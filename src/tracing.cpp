@@ -0,0 +1,268 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include "../include/ionicengine/tracing.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ionicengine
+{
+	namespace tracing
+	{
+		enum TracePhase : char
+		{
+			PHASE_BEGIN = 'B',
+			PHASE_END = 'E',
+			PHASE_INSTANT = 'i'
+		};
+
+		struct TraceEvent
+		{
+			const char *name;
+			uint64_t time;
+			TracePhase phase;
+		};
+
+		/*!
+		 * The events of one thread. Only the owning thread writes, the events below the count are never modified
+		 * until the next capture, so they can be read from another thread.
+		 */
+		struct ThreadBuffer
+		{
+			uint32_t id;
+			std::atomic<const char *> name{nullptr};
+			std::atomic<uint64_t> session{0};
+			std::unique_ptr<TraceEvent[]> events;
+			size_t capacity = 0;
+			std::atomic<size_t> count{0};
+			// The scopes recorded and not ended yet, their end events always have room.
+			size_t open = 0;
+		};
+
+		std::atomic<bool> enabled{false};
+		// Incremented by every capture, a buffer recorded in a previous capture is reset by its thread.
+		std::atomic<uint64_t> session{0};
+		std::atomic<size_t> capacity{IONIC_TRACE_DEFAULT_CAPACITY};
+		std::atomic<uint64_t> dropped{0};
+		uint64_t origin = 0;
+
+		// Locked only when a thread records its first event, and when the capture is written.
+		std::mutex buffers_mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+		thread_local ThreadBuffer *thread_buffer = nullptr;
+		thread_local const char *thread_name = nullptr;
+
+		inline uint64_t now()
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		/*!
+		 * Gets the buffer of the calling thread for the current capture, reset if it belongs to a previous one.
+		 */
+		ThreadBuffer *get_thread_buffer()
+		{
+			if (thread_buffer == nullptr)
+			{
+				std::lock_guard<std::mutex> lock{buffers_mutex};
+				buffers.push_back(std::make_unique<ThreadBuffer>());
+				thread_buffer = buffers.back().get();
+				thread_buffer->id = static_cast<uint32_t>(buffers.size());
+				thread_buffer->name = thread_name;
+			}
+
+			auto current = session.load(std::memory_order_acquire);
+			if (thread_buffer->session.load(std::memory_order_relaxed) != current)
+			{
+				auto events = capacity.load(std::memory_order_relaxed);
+				if (thread_buffer->capacity != events)
+				{
+					thread_buffer->events.reset(new TraceEvent[events]);
+					thread_buffer->capacity = events;
+				}
+				thread_buffer->count.store(0, std::memory_order_relaxed);
+				thread_buffer->open = 0;
+				thread_buffer->session.store(current, std::memory_order_release);
+			}
+			return thread_buffer;
+		}
+
+		/*!
+		 * Appends an event to the buffer of the calling thread.
+		 * @param reserved The number of events which must still fit after this one.
+		 * @return True if the event was recorded, else false.
+		 */
+		bool record(ThreadBuffer *buffer, const char *name, TracePhase phase, size_t reserved)
+		{
+			auto count = buffer->count.load(std::memory_order_relaxed);
+			if (count + buffer->open + 1 + reserved > buffer->capacity)
+			{
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			buffer->events[count] = {name, now(), phase};
+			buffer->count.store(count + 1, std::memory_order_release);
+			return true;
+		}
+
+		void write_json_string(std::ostream &output, const char *string)
+		{
+			output << '"';
+			for (const char *c = string == nullptr ? "" : string; *c != '\0'; c++)
+			{
+				if (*c == '"' || *c == '\\')
+					output << '\\' << *c;
+				else if (static_cast<unsigned char>(*c) < 0x20)
+				{
+					char escaped[8];
+					std::snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+					output << escaped;
+				}
+				else
+					output << *c;
+			}
+			output << '"';
+		}
+
+		bool IONICENGINE_API is_enabled()
+		{
+			return enabled.load(std::memory_order_relaxed);
+		}
+
+		void IONICENGINE_API start(size_t events)
+		{
+			enabled.store(false, std::memory_order_relaxed);
+			capacity.store(events == 0 ? 1 : events, std::memory_order_relaxed);
+			dropped.store(0, std::memory_order_relaxed);
+			origin = now();
+			session.fetch_add(1, std::memory_order_release);
+			enabled.store(true, std::memory_order_release);
+		}
+
+		void IONICENGINE_API stop()
+		{
+			enabled.store(false, std::memory_order_release);
+		}
+
+		void IONICENGINE_API set_thread_name(const char *name)
+		{
+			thread_name = name;
+			if (thread_buffer != nullptr)
+				thread_buffer->name = name;
+		}
+
+		bool IONICENGINE_API begin(const char *name)
+		{
+			if (!enabled.load(std::memory_order_acquire))
+				return false;
+			auto buffer = get_thread_buffer();
+			// Room is kept for the end event.
+			if (!record(buffer, name, PHASE_BEGIN, 1))
+				return false;
+			buffer->open++;
+			return true;
+		}
+
+		void IONICENGINE_API end()
+		{
+			auto buffer = thread_buffer;
+			// A scope begun in a previous capture was discarded with it.
+			if (buffer == nullptr || buffer->open == 0 ||
+				buffer->session.load(std::memory_order_relaxed) != session.load(std::memory_order_acquire))
+				return;
+			buffer->open--;
+			record(buffer, nullptr, PHASE_END, 0);
+		}
+
+		void IONICENGINE_API instant(const char *name)
+		{
+			if (!enabled.load(std::memory_order_acquire))
+				return;
+			record(get_thread_buffer(), name, PHASE_INSTANT, 0);
+		}
+
+		uint64_t IONICENGINE_API get_dropped_events()
+		{
+			return dropped.load(std::memory_order_relaxed);
+		}
+
+		bool IONICENGINE_API write(const std::string &path)
+		{
+			std::ofstream output{path, std::ios::trunc};
+			if (!output)
+				return false;
+
+			auto current = session.load(std::memory_order_acquire);
+			bool first = true;
+			auto separate = [&output, &first]()
+			{
+				output << (first ? "\n" : ",\n");
+				first = false;
+			};
+
+			output << "{\"traceEvents\":[";
+			std::lock_guard<std::mutex> lock{buffers_mutex};
+			for (const auto &buffer : buffers)
+			{
+				if (buffer->session.load(std::memory_order_acquire) != current)
+					continue;
+				auto count = buffer->count.load(std::memory_order_acquire);
+				if (count == 0)
+					continue;
+
+				const char *name = buffer->name;
+				if (name != nullptr)
+				{
+					separate();
+					output << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->id << R"(,"args":{"name":)";
+					write_json_string(output, name);
+					output << "}}";
+				}
+
+				for (size_t i = 0; i < count; i++)
+				{
+					const auto &event = buffer->events[i];
+					char timestamp[32];
+					// Chrome traces are in microseconds.
+					std::snprintf(timestamp, sizeof(timestamp), "%.3f",
+								  static_cast<double>(event.time - origin) / 1000.0);
+					separate();
+					output << R"({"ph":")" << static_cast<char>(event.phase) << R"(","pid":1,"tid":)" << buffer->id
+						   << R"(,"ts":)" << timestamp;
+					if (event.name != nullptr)
+					{
+						output << R"(,"name":)";
+						write_json_string(output, event.name);
+					}
+					if (event.phase == PHASE_INSTANT)
+						output << R"(,"s":"t")";
+					output << '}';
+				}
+			}
+			output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+			return static_cast<bool>(output);
+		}
+
+		TraceScope::TraceScope(const char *name) : _active(begin(name))
+		{}
+
+		TraceScope::~TraceScope()
+		{
+			if (_active)
+				end();
+		}
+	}
+}
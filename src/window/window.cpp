@@ -9,6 +9,7 @@
 
 #include "../../include/ionicengine/window/window.h"
 #include "../../include/ionicengine/input/inputmanager.h"
+#include "../../include/ionicengine/gl/state.h"
 
 namespace ionicengine
 {
@@ -128,6 +129,11 @@ namespace ionicengine
 		glfwIconifyWindow(_pointer);
 	}
 
+	bool Window::is_iconified() const
+	{
+		return glfwGetWindowAttrib(_pointer, GLFW_ICONIFIED) == GLFW_TRUE;
+	}
+
 	void Window::maximize() const
 	{
 		glfwMaximizeWindow(_pointer);
@@ -155,7 +161,11 @@ namespace ionicengine
 
 	void Window::request_context() const
 	{
+		// Called every frame, the cached state is only dropped when another context was current.
+		if (glfwGetCurrentContext() == _pointer)
+			return;
 		glfwMakeContextCurrent(_pointer);
+		glstate::invalidate();
 	}
 
 	void Window::destroy()
@@ -9,15 +9,23 @@
 
 #include <ionicengine/graphics/screen.h>
 #include <ionicengine/graphics/animation.h>
+#include <ionicengine/graphics/particles.h>
 #include <ionicengine/input/inputmanager.h>
+#include <ionicengine/profiler.h>
+#include <ionicengine/tracing.h>
 #include <ionicengine/sound/wav.h>
 #include <lambdacommon/system/terminal.h>
+#include <lambdacommon/maths.h>
+#include <cmath>
+#include <random>
 
 using namespace ionicengine;
 using namespace lambdacommon;
 
 BitmapAnimation *fire_animation = nullptr, *cat_animation = nullptr;
 TexturesAnimation *fire_light_animation = nullptr;
+ParticleSystem embers{20000};
+std::optional<Texture> ember_texture;
 
 bool sounds_state = true;
 
@@ -47,6 +55,32 @@ public:
 
 				sounds_state = !sounds_state;
 			}
+			else if (key == GLFW_KEY_F3)
+			{
+				auto screens = screen::get_screen_manager(window);
+				if (screens->is_overlay_active(IONICENGINE_OVERLAYS_PROFILER))
+				{
+					screens->remove_active_overlay(IONICENGINE_OVERLAYS_PROFILER);
+					profiler::set_enabled(false);
+				}
+				else
+				{
+					profiler::set_enabled(true);
+					screens->add_active_overlay(IONICENGINE_OVERLAYS_PROFILER);
+				}
+			}
+			else if (key == GLFW_KEY_F4)
+			{
+				// F4 starts a capture, pressing it again writes it for a trace viewer.
+				if (tracing::is_enabled())
+				{
+					tracing::stop();
+					if (tracing::write("fire_trace.json"))
+						std::cout << "Trace written to fire_trace.json." << std::endl;
+				}
+				else
+					tracing::start();
+			}
 		}
 	}
 
@@ -60,6 +94,8 @@ private:
 	Color grass_color = color::mix(Color::COLOR_GREEN, Color::COLOR_BLACK, 0.5f);
 	uint32_t fire_x = 0, fire_y = 0, quad_y = 0;
 	int fire_place = 0, crickets = 0;
+	std::mt19937 random{42};
+	ResourceHandle sky = resource::intern({"ionicengine:textures/sky/night01"});
 
 public:
 	MainScreen()
@@ -78,7 +114,7 @@ public:
 
 	void draw(Graphics *graphics) override
 	{
-		graphics->draw_image({"ionicengine:textures/sky/night01"}, 0, 0, width, height);
+		graphics->draw_image(sky, 0, 0, width, height);
 		graphics->set_color(grass_color);
 		graphics->draw_quad(0, quad_y, width, height - quad_y);
 		graphics->set_color(Color::COLOR_WHITE);
@@ -91,6 +127,7 @@ public:
 		cat_animation->set_x(width / 2 + 32);
 		cat_animation->set_y(height / 2 - 128 + 32);
 		cat_animation->render(graphics);
+		embers.draw(graphics, *ember_texture);
 
 		Screen::draw(graphics);
 	}
@@ -101,6 +138,14 @@ public:
 		fire_animation->update();
 		fire_light_animation->update();
 		cat_animation->update();
+		if (fire_animation->is_running())
+		{
+			std::uniform_real_distribution<float> spread{-64.f, 64.f}, speed{-160.f, -60.f}, lifetime{.5f, 2.f};
+			for (int i = 0; i < 100; i++)
+				embers.emit({fire_x + 256 + spread(random), fire_y + 200.f, spread(random) / 4.f, speed(random),
+							 lifetime(random)});
+		}
+		embers.update(0.020f);
 		if (sounds_state)
 			sound::resume_all();
 		else
@@ -172,6 +217,22 @@ int main()
 	bitmap_animation->set_invert_on_repeat(true);
 	cat_animation = bitmap_animation;
 
+	// A soft round dot for the embers.
+	unsigned char ember_image[16 * 16 * 4];
+	for (int y = 0; y < 16; y++)
+		for (int x = 0; x < 16; x++)
+		{
+			auto distance = std::sqrt((x - 7.5f) * (x - 7.5f) + (y - 7.5f) * (y - 7.5f)) / 8.f;
+			auto pixel = ember_image + (y * 16 + x) * 4;
+			pixel[0] = pixel[1] = pixel[2] = 255;
+			pixel[3] = static_cast<unsigned char>(255 * maths::clamp(1.f - distance, 0.f, 1.f));
+		}
+	ember_texture = texture::create({"ionic_tests:textures/ember"}, ember_image, 16, 16, 4, CLAMP, LINEAR, false);
+	embers.set_acceleration(0.f, 40.f);
+	embers.set_color({1.f, .8f, .3f, 1.f}, {.8f, .1f, 0.f, 0.f});
+	embers.set_size(6.f, 2.f);
+	std::cout << "Updating the embers with " << ParticleSystem::get_instruction_set() << " kernels.\n";
+
 	auto font = ionicengine::get_font_manager()->load_font({"google:fonts/roboto"}, std::string{"Roboto.ttf"}, 14);
 	if (!font)
 	{
@@ -187,8 +248,12 @@ int main()
 	}
 
 	OverlayFPS overlay{font.value()};
+	overlay.set_show_render_stats(true);
 	screens.register_overlay(IONICENGINE_OVERLAYS_FPS, &overlay);
 	screens.add_active_overlay(IONICENGINE_OVERLAYS_FPS);
+	// F3 toggles the profiler.
+	OverlayProfiler profiler_overlay{font.value()};
+	screens.register_overlay(IONICENGINE_OVERLAYS_PROFILER, &profiler_overlay);
 
 	ResourceName screens_image{"ionic_tests:screens/image"};
 
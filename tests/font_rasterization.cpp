@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include <ionicengine/ionicengine.h>
+#include <ionicengine/threadpool.h>
+#include <lambdacommon/system/system.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+using namespace lambdacommon;
+using namespace ionicengine;
+
+#define FIRST_CODEPOINT 0x20
+#define LAST_CODEPOINT 0x24F
+
+double measure(const std::function<void()> &function)
+{
+	auto start = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+	terminal::setup();
+	std::cout << "Running ionic_font_rasterization with IonicEngine v" + ionicengine::get_version() << "...\n";
+
+	std::string path = argc > 1 ? argv[1] : "Roboto.ttf";
+
+	IonicOptions ionic_options;
+	ionic_options.use_controllers = false;
+	if (!ionicengine::init(ionic_options))
+		return EXIT_FAILURE;
+	// The cache would skip the rasterization of the second run.
+	get_font_manager()->set_cache_directory("");
+
+	std::cout << "Rasterizing U+" << std::hex << FIRST_CODEPOINT << " to U+" << LAST_CODEPOINT << std::dec << " of '"
+			  << path << "' with " << (get_worker_pool().get_thread_count() + 1) << " threads." << std::endl;
+
+	for (uint32_t size : {12, 24, 48, 96})
+	{
+		auto serial_font = get_font_manager()->load_font({"ionic_tests:fonts/serial_" + std::to_string(size)}, path,
+														 size);
+		auto parallel_font = get_font_manager()->load_font({"ionic_tests:fonts/parallel_" + std::to_string(size)},
+														   path, size);
+		if (!serial_font || !parallel_font)
+		{
+			std::cerr << "Cannot load the font '" << path << "'." << std::endl;
+			ionicengine::shutdown();
+			return EXIT_FAILURE;
+		}
+
+		auto serial = measure([&serial_font]()
+							  {
+								  for (char32_t codepoint = FIRST_CODEPOINT; codepoint <= LAST_CODEPOINT; codepoint++)
+									  serial_font->get_character(codepoint);
+							  });
+		auto parallel = measure([&parallel_font]()
+								{
+									parallel_font->preload(FIRST_CODEPOINT, LAST_CODEPOINT);
+								});
+
+		std::cout << std::fixed << std::setprecision(2) << "Size " << size << "px: serial " << serial
+				  << "ms, parallel " << parallel << "ms, speedup x" << (serial / parallel) << std::endl;
+	}
+
+	ionicengine::shutdown();
+	return EXIT_SUCCESS;
+}
@@ -34,6 +34,7 @@ class MainScreen : public Screen
 {
 private:
 	Texture texture;
+	ResourceHandle background = resource::intern({"ionic_tests:textures/conifer-dark-green-daylight-572937"});
 
 public:
 	MainScreen(const Texture &texture) : texture(texture)
@@ -48,8 +49,7 @@ public:
 		auto texture_width = width, texture_height = height;
 		uint32_t quad_width = texture_width - (ratio5_width * 2), qued_height = texture_height - (ratio5_height * 2);
 		graphics->set_color(Color::COLOR_WHITE);
-		graphics->draw_image({"ionic_tests:textures/conifer-dark-green-daylight-572937"}, 0, 0, texture_width,
-							 texture_height);
+		graphics->draw_image(background, 0, 0, texture_width, texture_height);
 		graphics->draw_image(texture, ratio5_width, ratio5_height, quad_width, qued_height, texture::new_texture_region(
 				texture_width, texture_height,
 				static_cast<uint32_t>(ratio5_width), static_cast<uint32_t>(ratio5_height),
@@ -101,11 +101,12 @@ int main()
 		return EXIT_FAILURE;
 	}
 
-	auto texture = texture::load({"ionic_tests:textures/conifer-dark-green-daylight-572937"}, "jpg", CLAMP,
-								 LINEAR_MIPMAP_LINEAR);
+	// The background is drawn by name, it shows up once streamed in by the screen loop.
+	texture::load_async({"ionic_tests:textures/conifer-dark-green-daylight-572937"}, "jpg", CLAMP,
+						LINEAR_MIPMAP_LINEAR);
 	auto texture_blurred = texture::load({"ionic_tests:textures/conifer-dark-green-daylight-572937-blurred"}, "jpg",
 										 CLAMP, LINEAR_MIPMAP_LINEAR);
-	if (!texture || !texture_blurred)
+	if (!texture_blurred)
 	{
 		std::cerr << "Cannot load textures!\n";
 		ionicengine::shutdown();
@@ -25,6 +25,7 @@ public:
 	explicit MainScreen(const Font &font) : _font(font)
 	{
 		set_background_color(color::from_hex(0xEEEEEEFF));
+		set_cached(true);
 	}
 
 	void init() override
@@ -52,7 +53,13 @@ public:
 	{
 		Screen::update();
 		float usage = static_cast<float>(system::get_memory_used()) / system::get_memory_total();
-		progress_bar->set_progress(static_cast<uint32_t>(usage * 100));
+		auto progress = static_cast<uint32_t>(usage * 100);
+		// The loop draws on demand, only the text and the progress bar are drawn again when the usage changes.
+		if (progress != progress_bar->get_progress())
+		{
+			progress_bar->set_progress(progress);
+			add_damage(0, 0, width, 10 + _font.get_height());
+		}
 	}
 };
 
@@ -102,6 +109,12 @@ int main()
 
 	screens.attach_window(window);
 
+	LoopOptions loop_options;
+	loop_options.swap_interval = 1;
+	loop_options.unfocused_fps = 10;
+	loop_options.on_demand = true;
+	screens.set_loop_options(loop_options);
+
 	screens.start_loop();
 
 	ionicengine::shutdown();
@@ -19,6 +19,12 @@ using namespace ionicengine;
 
 std::string textArea{""};
 
+void erase_last_codepoint()
+{
+	if (!textArea.empty())
+		textArea.erase(utf8::previous(textArea, textArea.size()));
+}
+
 class KeyboardListenerImpl : public KeyboardListener
 {
 public:
@@ -29,7 +35,7 @@ public:
 			if (key == GLFW_KEY_ESCAPE)
 				window.set_should_close(true);
 			else if (key == GLFW_KEY_BACKSPACE)
-				textArea = textArea.substr(0, textArea.length() - 1);
+				erase_last_codepoint();
 			else if (key == GLFW_KEY_ENTER || key == GLFW_KEY_KP_ENTER)
 				textArea += "\n";
 			else if (key == GLFW_KEY_C && mods == GLFW_MOD_CONTROL)
@@ -40,13 +46,13 @@ public:
 		else if (action == InputAction::REPEAT)
 		{
 			if (key == GLFW_KEY_BACKSPACE)
-				textArea = textArea.substr(0, textArea.length() - 1);
+				erase_last_codepoint();
 		}
 	}
 
 	void on_char_input(Window &window, char32_t codepoint) override
 	{
-		textArea += static_cast<char>(codepoint);
+		utf8::append(textArea, codepoint);
 	}
 };
 
@@ -55,6 +61,7 @@ class TextArea : public Screen
 private:
 	Font font;
 	Texture texture;
+	ResourceHandle background = resource::intern({"ionic_tests:textures/conifer-dark-green-daylight-572937"});
 	bool increase_opacity = true;
 	float opacity = 0.f;
 
@@ -71,8 +78,7 @@ public:
 		auto texture_width = width, texture_height = height;
 		uint32_t quad_width = texture_width - (ratio5_width * 2), quad_height = texture_height - (ratio5_height * 2);
 		graphics->set_color(Color::COLOR_WHITE);
-		graphics->draw_image({"ionic_tests:textures/conifer-dark-green-daylight-572937"}, 0, 0, texture_width,
-							 texture_height);
+		graphics->draw_image(background, 0, 0, texture_width, texture_height);
 		graphics->draw_image(texture, ratio5_width, ratio5_height, quad_width, quad_height, texture::new_texture_region(
 				texture_width, texture_height, static_cast<uint32_t>(ratio5_width),
 				static_cast<uint32_t>(ratio5_height),
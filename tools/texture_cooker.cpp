@@ -0,0 +1,99 @@
+/*
+ * Copyright © 2018 AperLambda <aperlambda@gmail.com>
+ *
+ * This file is part of IonicEngine.
+ *
+ * Licensed under the MIT license. For more information,
+ * see the LICENSE file.
+ */
+
+#include <ionicengine/graphics/cookedtexture.h>
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+using namespace ionicengine;
+
+static bool is_image(const fs::path &path)
+{
+	auto extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" ||
+		   extension == ".tga";
+}
+
+static void print_usage(const char *program)
+{
+	std::cout << "Usage: " << program << " [--compress] [--no-mipmaps] [--force] <resources directory>" << std::endl;
+	std::cout << "Cooks every image of the directory into a file next to it with ." << IONIC_COOKED_TEXTURE_EXTENSION
+			  << " appended to its name." << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	CookOptions options;
+	bool force = false;
+	std::string directory;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "--compress")
+			options.compress = true;
+		else if (argument == "--no-mipmaps")
+			options.mipmaps = false;
+		else if (argument == "--force")
+			force = true;
+		else if (argument == "--help" || argument == "-h")
+		{
+			print_usage(argv[0]);
+			return 0;
+		}
+		else
+			directory = argument;
+	}
+
+	if (directory.empty() || !fs::is_directory(directory))
+	{
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	uint32_t cooked = 0, skipped = 0, failed = 0;
+	for (const auto &entry : fs::recursive_directory_iterator(directory))
+	{
+		if (!entry.is_regular_file() || !is_image(entry.path()))
+			continue;
+
+		auto source = entry.path();
+		// The source extension is kept, "image.png" and "image.jpg" are cooked into different files.
+		auto output = fs::path{source.string() + "." + IONIC_COOKED_TEXTURE_EXTENSION};
+
+		if (!force)
+		{
+			// Only the images changed or cooked with other options since their last cooking are cooked again.
+			CookedTexture existing;
+			if (existing.open(output.string()) && existing.is_up_to_date(source.string()) &&
+				existing.was_cooked_with(options))
+			{
+				skipped++;
+				continue;
+			}
+		}
+
+		if (texture::cook(source.string(), output.string(), options))
+		{
+			std::cout << "Cooked '" << source.string() << "'." << std::endl;
+			cooked++;
+		}
+		else
+		{
+			std::cerr << "Failed to cook '" << source.string() << "'." << std::endl;
+			failed++;
+		}
+	}
+
+	std::cout << cooked << " cooked, " << skipped << " up to date, " << failed << " failed." << std::endl;
+	return failed == 0 ? 0 : 1;
+}